@@ -0,0 +1,580 @@
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <optional>
+#include <random>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "src/allocator/allocator.h"
+#include "src/list/concurrent_queue.h"
+#include "src/list/list.h"
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+constexpr std::size_t kOperations = 10'000'000;
+
+// Calls to the global operator new, which both std::allocator and the
+// CustomAllocator arenas end up in.
+std::atomic<std::size_t> heap_allocations{0};
+
+}  // namespace
+
+// Kept out of line so that GCC does not see malloc and free meet a new
+// expression and a delete expression and warn about a mismatch.
+[[gnu::noinline]] void* operator new(std::size_t bytes) {
+    heap_allocations.fetch_add(1, std::memory_order_relaxed);
+    if (void* p = std::malloc(bytes == 0 ? 1 : bytes)) {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+[[gnu::noinline]] void operator delete(void* p) noexcept {
+    std::free(p);
+}
+
+[[gnu::noinline]] void operator delete(void* p, std::size_t) noexcept {
+    std::free(p);
+}
+
+namespace {
+
+// A monotonic arena that does not follow its list on move-assignment, so a
+// move between lists on different arenas has to move element by element.
+template <typename T>
+class StickyArena : public CustomAllocator<T> {
+public:
+    template <typename U>
+    struct rebind {  // NOLINT
+        using other = StickyArena<U>;
+    };
+
+    using propagate_on_container_move_assignment = std::false_type;
+
+    StickyArena() : CustomAllocator<T>(kMonotonicArena) {
+    }
+
+    template <typename U>
+    explicit StickyArena(const StickyArena<U>& other) : CustomAllocator<T>(other) {
+    }
+};
+
+template <typename F>
+double MeasureMs(F&& body) {
+    auto start = std::chrono::steady_clock::now();
+    body();
+    auto finish = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::milli>(finish - start).count();
+}
+
+template <typename Allocator>
+void PushBack(task::List<int, Allocator>& list, int value) {
+    list.PushBack(value);
+}
+
+template <typename Allocator>
+void PushBack(std::list<int, Allocator>& list, int value) {
+    list.push_back(value);
+}
+
+template <typename Allocator>
+void Clear(task::List<int, Allocator>& list) {
+    list.Clear();
+}
+
+template <typename Allocator>
+void Clear(std::list<int, Allocator>& list) {
+    list.clear();
+}
+
+// kOperations pushes into one list, then a single Clear.
+template <typename List>
+void ReportPushBack(const char* name) {
+    List list;
+    double push_ms = MeasureMs([&] {
+        for (std::size_t i = 0; i < kOperations; ++i) {
+            PushBack(list, static_cast<int>(i));
+        }
+    });
+    double clear_ms = MeasureMs([&] { Clear(list); });
+    std::printf("%-36s %10.2f %10.2f\n", name, push_ms, clear_ms);
+}
+
+// The same number of pushes in short bursts, each followed by a Clear: the
+// pattern where freed nodes are immediately reused.
+template <typename List>
+void ReportChurn(const char* name) {
+    constexpr std::size_t kBurst = 1000;
+    List list;
+    double ms = MeasureMs([&] {
+        for (std::size_t round = 0; round < kOperations / kBurst; ++round) {
+            for (std::size_t i = 0; i < kBurst; ++i) {
+                PushBack(list, static_cast<int>(i));
+            }
+            Clear(list);
+        }
+    });
+    std::printf("%-36s %10.2f\n", name, ms);
+}
+
+// Builds a kOperations list with the given allocator and times its
+// destruction alone.
+template <typename Allocator>
+void ReportTeardown(const char* name, const Allocator& alloc) {
+    auto list = std::make_unique<task::List<int, Allocator>>(alloc);
+    for (std::size_t i = 0; i < kOperations; ++i) {
+        list->PushBack(static_cast<int>(i));
+    }
+    std::printf("%-36s %10.2f\n", name, MeasureMs([&] { list.reset(); }));
+}
+
+// Move-assigns a kOperations list into a list on the target arena.
+void ReportMoveAssign(const char* name, const StickyArena<int>& source_arena,
+                      const StickyArena<int>& target_arena) {
+    task::List<int, StickyArena<int>> source(source_arena);
+    task::List<int, StickyArena<int>> target(target_arena);
+    for (std::size_t i = 0; i < kOperations; ++i) {
+        source.PushBack(static_cast<int>(i));
+    }
+    std::printf("%-36s %10.2f\n", name, MeasureMs([&] { target = std::move(source); }));
+}
+
+// A mixed-size allocation trace: each step either allocates, with sizes
+// drawn mostly from small string and vector lengths and now and then a large
+// buffer, or frees a random live allocation. The live set hovers around
+// kTraceLive allocations.
+struct TraceStep {
+    bool allocate;
+    std::size_t bytes_or_slot;
+};
+
+constexpr std::size_t kTraceLive = 10'000;
+
+std::vector<TraceStep> MakeTrace(std::size_t steps) {
+    std::mt19937 gen(42);
+    std::geometric_distribution<std::size_t> small(1.0 / 48);
+    std::uniform_int_distribution<std::size_t> large(8193, 65536);
+    std::uniform_int_distribution<std::size_t> percent(0, 99);
+    std::vector<TraceStep> trace;
+    std::size_t live = 0;
+    for (std::size_t i = 0; i < steps; ++i) {
+        const std::size_t allocate_percent = live < kTraceLive ? 55 : 50;
+        const bool allocate =
+            live == 0 || (live < 2 * kTraceLive && percent(gen) < allocate_percent);
+        if (allocate) {
+            trace.push_back({true, percent(gen) == 0 ? large(gen) : 2 + small(gen)});
+            ++live;
+        } else {
+            std::uniform_int_distribution<std::size_t> slot(0, live - 1);
+            trace.push_back({false, slot(gen)});
+            --live;
+        }
+    }
+    return trace;
+}
+
+// Calls inspect while the allocations live at the end of the trace are still
+// held.
+template <typename Allocator, typename Inspect = void (*)()>
+double ReplayTrace(const std::vector<TraceStep>& trace, Allocator& alloc,
+                   Inspect inspect = [] {}) {
+    std::vector<std::pair<char*, std::size_t>> live;
+    live.reserve(2 * kTraceLive + 1);
+    double ms = MeasureMs([&] {
+        for (const TraceStep& step : trace) {
+            if (step.allocate) {
+                live.emplace_back(alloc.allocate(step.bytes_or_slot), step.bytes_or_slot);
+            } else {
+                std::swap(live[step.bytes_or_slot], live.back());
+                alloc.deallocate(live.back().first, live.back().second);
+                live.pop_back();
+            }
+        }
+    });
+    inspect();
+    for (auto& [p, bytes] : live) {
+        alloc.deallocate(p, bytes);
+    }
+    return ms;
+}
+
+// Every thread churns its own List through one shared allocator: kOperations
+// pushes in total, split evenly, with a PopFront for every second push and a
+// Clear every kBurst pushes.
+template <typename Allocator>
+double Stress(std::size_t thread_count) {
+    constexpr std::size_t kBurst = 1000;
+    using List = task::List<int, Allocator>;
+    Allocator alloc;
+    const std::size_t per_thread = kOperations / thread_count;
+    return MeasureMs([&] {
+        std::vector<std::thread> threads;
+        for (std::size_t t = 0; t < thread_count; ++t) {
+            threads.emplace_back([&alloc, per_thread] {
+                List list(alloc);
+                for (std::size_t i = 0; i < per_thread; ++i) {
+                    list.PushBack(static_cast<int>(i));
+                    if (i % 2 == 1) {
+                        list.PopFront();
+                    }
+                    if (i % kBurst == kBurst - 1) {
+                        list.Clear();
+                    }
+                }
+            });
+        }
+        for (std::thread& thread : threads) {
+            thread.join();
+        }
+    });
+}
+
+void ReportStress(std::size_t thread_count) {
+    std::printf("%-36zu %10.2f %10.2f\n", thread_count, Stress<std::allocator<int>>(thread_count),
+                Stress<CustomAllocator<int>>(thread_count));
+}
+
+// The usual way to share a List between threads.
+template <typename T>
+class LockedList {
+public:
+    void PushBack(T value) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        list_.PushBack(std::move(value));
+    }
+
+    std::optional<T> PopFront() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (list_.Empty()) {
+            return std::nullopt;
+        }
+        std::optional<T> value(std::move(list_.Front()));
+        list_.PopFront();
+        return value;
+    }
+
+private:
+    std::mutex mutex_;
+    task::List<T, CustomAllocator<T>> list_;
+};
+
+// Every thread pushes and pops in turn on one shared queue, kOperations
+// operations in total split evenly, so the queue stays short and all the
+// threads fight over both of its ends.
+template <typename Queue>
+double QueueThroughput(std::size_t thread_count) {
+    Queue queue;
+    const std::size_t per_thread = kOperations / 2 / thread_count;
+    return MeasureMs([&] {
+        std::vector<std::thread> threads;
+        for (std::size_t t = 0; t < thread_count; ++t) {
+            threads.emplace_back([&queue, per_thread] {
+                for (std::size_t i = 0; i < per_thread; ++i) {
+                    queue.PushBack(static_cast<int>(i));
+                    queue.PopFront();
+                }
+            });
+        }
+        for (std::thread& thread : threads) {
+            thread.join();
+        }
+    });
+}
+
+void ReportQueue(std::size_t thread_count) {
+    std::printf("%-36zu %10.2f %10.2f\n", thread_count,
+                QueueThroughput<LockedList<int>>(thread_count),
+                QueueThroughput<task::ConcurrentQueue<int>>(thread_count));
+}
+
+// Counts data-TLB load misses of this thread in user space. Reports -1 where
+// perf events are unavailable: not Linux, or blocked by perf_event_paranoid
+// or a sandbox.
+class DtlbMisses {
+public:
+    DtlbMisses() {
+#ifdef __linux__
+        perf_event_attr attr;
+        std::memset(&attr, 0, sizeof(attr));
+        attr.size = sizeof(attr);
+        attr.type = PERF_TYPE_HW_CACHE;
+        attr.config = PERF_COUNT_HW_CACHE_DTLB | (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+                      (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+        attr.disabled = 1;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        fd_ = static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0));
+#endif
+    }
+
+    DtlbMisses(const DtlbMisses&) = delete;
+    DtlbMisses& operator=(const DtlbMisses&) = delete;
+
+    ~DtlbMisses() {
+#ifdef __linux__
+        if (fd_ >= 0) {
+            close(fd_);
+        }
+#endif
+    }
+
+    template <typename F>
+    long long Count(F&& body) {
+#ifdef __linux__
+        if (fd_ >= 0) {
+            ioctl(fd_, PERF_EVENT_IOC_RESET, 0);
+            ioctl(fd_, PERF_EVENT_IOC_ENABLE, 0);
+            body();
+            ioctl(fd_, PERF_EVENT_IOC_DISABLE, 0);
+            long long misses = 0;
+            if (read(fd_, &misses, sizeof(misses)) == sizeof(misses)) {
+                return misses;
+            }
+            return -1;
+        }
+#endif
+        body();
+        return -1;
+    }
+
+private:
+    int fd_ = -1;
+};
+
+// Sums a list built in insertion order, whose nodes lie in allocation order,
+// and the same list after sorting random keys, whose nodes are scattered over
+// the whole arena. Reports ns and dTLB misses per node for the scattered walk.
+template <typename Allocator>
+void ReportTraversal(const char* name, const Allocator& alloc) {
+    constexpr std::size_t kNodes = 2'000'000;
+    constexpr int kPasses = 5;
+    std::mt19937 gen(7);
+    task::List<std::uint32_t, Allocator> list(alloc);
+    for (std::size_t i = 0; i < kNodes; ++i) {
+        list.PushBack(static_cast<std::uint32_t>(gen()));
+    }
+
+    volatile std::uint64_t sink = 0;
+    auto walk = [&] {
+        for (int pass = 0; pass < kPasses; ++pass) {
+            std::uint64_t sum = 0;
+            for (std::uint32_t value : list) {
+                sum += value;
+            }
+            sink = sink + sum;
+        }
+    };
+    const double nodes = static_cast<double>(kNodes) * kPasses;
+    const double sequential_ns = MeasureMs(walk) * 1e6 / nodes;
+    list.Sort();
+    DtlbMisses misses;
+    double scattered_ms = 0;
+    const long long scattered_misses = misses.Count([&] { scattered_ms = MeasureMs(walk); });
+    std::printf("%-36s %10.2f %10.2f %10.3f\n", name, sequential_ns, scattered_ms * 1e6 / nodes,
+                scattered_misses < 0 ? -1.0 : static_cast<double>(scattered_misses) / nodes);
+}
+
+// Scatters a list's nodes with churn, then times a forward walk before and
+// after Compact in each mode, along with Compact itself.
+void ReportCompaction() {
+    constexpr std::size_t kNodes = 2'000'000;
+    constexpr int kPasses = 5;
+    std::printf("\n%zu node task::List after churn, walk ns per node\n", kNodes);
+    std::printf("%-36s %10s %10s %10s\n", "", "before", "compact ms", "after");
+    for (task::CompactMode mode : {task::CompactMode::kRelocate, task::CompactMode::kReuseNodes}) {
+        std::mt19937 gen(11);
+        task::List<std::uint32_t, CustomAllocator<std::uint32_t>> list;
+        while (list.Size() < kNodes) {
+            list.PushBack(static_cast<std::uint32_t>(gen()));
+            if (gen() % 4 == 0) {
+                list.PopFront();
+            }
+        }
+        // Sorting by value relinks the nodes into random address order.
+        list.Sort();
+
+        volatile std::uint64_t sink = 0;
+        auto walk = [&] {
+            for (int pass = 0; pass < kPasses; ++pass) {
+                std::uint64_t sum = 0;
+                for (std::uint32_t value : list) {
+                    sum += value;
+                }
+                sink = sink + sum;
+            }
+        };
+        const double nodes = static_cast<double>(kNodes) * kPasses;
+        const double before = MeasureMs(walk) * 1e6 / nodes;
+        const double compact_ms = MeasureMs([&] { list.Compact(mode); });
+        const double after = MeasureMs(walk) * 1e6 / nodes;
+        std::printf("%-36s %10.2f %10.2f %10.2f\n",
+                    mode == task::CompactMode::kRelocate ? "kRelocate" : "kReuseNodes", before,
+                    compact_ms, after);
+    }
+}
+
+// A string element that counts how often it is moved or copied.
+struct Payload {
+    static inline std::size_t moves = 0;
+    static inline std::size_t copies = 0;
+
+    explicit Payload(const std::string& text) : text(text) {
+    }
+
+    Payload(const Payload& other) : text(other.text) {
+        ++copies;
+    }
+
+    Payload(Payload&& other) noexcept : text(std::move(other.text)) {
+        ++moves;
+    }
+
+    std::string text;
+};
+
+// Fills a list with kElements strings too long for the small string buffer
+// in each of the ways List offers, counting heap allocations and element
+// moves and copies. Append copies from a prepared vector.
+template <typename Allocator>
+void ReportBulkAppend(const char* allocator_name) {
+    constexpr std::size_t kElements = 1'000'000;
+    const std::string text(32, 'x');
+    const std::vector<Payload> source(kElements, Payload(text));
+    using List = task::List<Payload, Allocator>;
+
+    auto report = [&](const char* how, auto fill) {
+        Payload::moves = 0;
+        Payload::copies = 0;
+        List list;
+        const std::size_t allocations = heap_allocations;
+        const double ms = MeasureMs([&] { fill(list); });
+        char name[64];
+        std::snprintf(name, sizeof(name), "%s, %s", how, allocator_name);
+        std::printf("%-36s %10.2f %10zu %10zu %10zu\n", name, ms, heap_allocations - allocations,
+                    Payload::moves, Payload::copies);
+    };
+    report("PushBack", [&](List& list) {
+        for (std::size_t i = 0; i < kElements; ++i) {
+            list.PushBack(Payload(text));
+        }
+    });
+    report("EmplaceBack", [&](List& list) {
+        for (std::size_t i = 0; i < kElements; ++i) {
+            list.EmplaceBack(text);
+        }
+    });
+    report("EmplaceBackN", [&](List& list) { list.EmplaceBackN(kElements, text); });
+    report("Append", [&](List& list) { list.Append(source.begin(), source.end()); });
+}
+
+ArenaOptions CacheLineChunks() {
+    ArenaOptions options;
+    options.cache_line_chunks = true;
+    return options;
+}
+
+ArenaOptions PaddedNodes() {
+    ArenaOptions options;
+    options.pad_to_cache_line = true;
+    return options;
+}
+
+ArenaOptions HugePages() {
+    ArenaOptions options;
+    options.huge_pages = true;
+    return options;
+}
+
+}  // namespace
+
+int main() {
+    std::printf("%zu PushBack, then one Clear\n", kOperations);
+    std::printf("%-36s %10s %10s\n", "", "push ms", "clear ms");
+    ReportPushBack<task::List<int, std::allocator<int>>>("task::List, std::allocator");
+    ReportPushBack<task::List<int, CustomAllocator<int>>>("task::List, CustomAllocator");
+    ReportPushBack<task::List<int, CustomAllocator<int, CollectStats>>>(
+        "task::List, CustomAllocator + stats");
+    ReportPushBack<std::list<int, std::allocator<int>>>("std::list, std::allocator");
+    ReportPushBack<std::list<int, CustomAllocator<int>>>("std::list, CustomAllocator");
+
+    std::printf("\n%zu PushBack in bursts of 1000, Clear after each\n", kOperations);
+    std::printf("%-36s %10s\n", "", "ms");
+    ReportChurn<task::List<int, std::allocator<int>>>("task::List, std::allocator");
+    ReportChurn<task::List<int, CustomAllocator<int>>>("task::List, CustomAllocator");
+    ReportChurn<std::list<int, std::allocator<int>>>("std::list, std::allocator");
+    ReportChurn<std::list<int, CustomAllocator<int>>>("std::list, CustomAllocator");
+
+    std::printf("\n%zu element task::List teardown\n", kOperations);
+    std::printf("%-36s %10s\n", "", "ms");
+    ReportTeardown("std::allocator", std::allocator<int>());
+    ReportTeardown("CustomAllocator", CustomAllocator<int>());
+    ReportTeardown("CustomAllocator, monotonic arena", CustomAllocator<int>(kMonotonicArena));
+
+    std::printf("\n%zu element task::List move-assignment\n", kOperations);
+    std::printf("%-36s %10s\n", "", "ms");
+    StickyArena<int> arena;
+    ReportMoveAssign("same arena", arena, arena);
+    ReportMoveAssign("different arenas", arena, StickyArena<int>());
+
+    std::printf("\n%zu step mixed-size allocation trace\n", kOperations);
+    std::printf("%-36s %10s\n", "", "ms");
+    const std::vector<TraceStep> trace = MakeTrace(kOperations);
+    std::allocator<char> std_alloc;
+    std::printf("%-36s %10.2f\n", "std::allocator", ReplayTrace(trace, std_alloc));
+    CustomAllocator<char> custom_alloc;
+    std::printf("%-36s %10.2f\n", "CustomAllocator", ReplayTrace(trace, custom_alloc));
+    CustomAllocator<char, CollectStats> stats_alloc;
+    ReplayTrace(trace, stats_alloc, [&stats_alloc] {
+        std::cout << "fragmentation at the end of the trace:\n"
+                  << Fragmentation(stats_alloc.GetStats());
+    });
+
+    std::printf("\n2000000 node task::List traversal, per node (dTLB -1: no perf counters)\n");
+    std::printf("%-36s %10s %10s %10s\n", "", "seq ns", "random ns", "dTLB miss");
+    ReportTraversal("std::allocator", std::allocator<std::uint32_t>());
+    ReportTraversal("CustomAllocator", CustomAllocator<std::uint32_t>());
+    ReportTraversal("CustomAllocator, cache-line chunks",
+                    CustomAllocator<std::uint32_t>(CacheLineChunks()));
+    ReportTraversal("CustomAllocator, padded nodes", CustomAllocator<std::uint32_t>(PaddedNodes()));
+    ReportTraversal("CustomAllocator, huge pages", CustomAllocator<std::uint32_t>(HugePages()));
+
+    ReportCompaction();
+
+    std::printf("\n1000000 string elements appended to a task::List\n");
+    std::printf("%-36s %10s %10s %10s %10s\n", "", "ms", "heap new", "moves", "copies");
+    ReportBulkAppend<std::allocator<Payload>>("std");
+    ReportBulkAppend<CustomAllocator<Payload>>("custom");
+
+    std::printf("\n%zu operations across threads, task::List per thread\n", kOperations);
+    std::printf("%-36s %10s %10s\n", "threads", "std ms", "custom ms");
+    for (std::size_t threads = 1; threads <= 64; threads *= 2) {
+        ReportStress(threads);
+    }
+
+    std::printf("\n%zu operations on one queue shared by all threads\n", kOperations);
+    std::printf("%-36s %10s %10s\n", "threads", "mutex ms", "lock-free");
+    for (std::size_t threads = 1; threads <= 32; threads *= 2) {
+        ReportQueue(threads);
+    }
+    return 0;
+}
@@ -1,53 +1,238 @@
+#pragma once
+
+#include <cstddef>
+#include <limits>
 #include <memory>
+#include <new>
+#include <ostream>
 #include <type_traits>
+#include <utility>
+
+#include "allocator_stats.h"
+#include "arena_options.h"
+#include "pool_resource.h"
+#include "size_classes.h"
+#include "stats_policy.h"
+
+// Selects the monotonic arena mode of CustomAllocator.
+struct MonotonicArena {
+    explicit MonotonicArena() = default;
+};
 
-template <typename T>
-class CustomAllocator {
+inline constexpr MonotonicArena kMonotonicArena{};
+
+// Stateful pool allocator. A default-constructed allocator owns a fresh
+// detail::PoolResource; copies and rebinds share it and compare equal, and
+// the resource with all of its memory goes away with the last of them.
+// Single-object requests, which is what node-based containers make, are
+// served from a fixed-block pool for sizeof(T) through a per-thread cache, so
+// copies may allocate and free on different threads concurrently. Array
+// requests of up to 8 KiB, as vectors and strings make, round up to one of 32
+// size classes with a pool each; larger ones fall through to operator new.
+//
+// An allocator constructed with kMonotonicArena, and its copies, never reuse
+// pooled blocks: deallocate on them is a no-op and the arena is freed in one
+// go with the last copy. Containers that see IsMonotonic() may drop trivially
+// destructible elements without visiting them.
+//
+// CustomAllocator(const ArenaOptions&) also controls chunk alignment, node
+// padding and huge-page backing; kMonotonicArena is shorthand for the options
+// with only monotonic set.
+//
+// Stats is NoStats or CollectStats. With CollectStats, GetStats() and
+// DumpStats() report the counters of the whole resource.
+template <typename T, typename Stats = NoStats>
+class CustomAllocator : private Stats {
 public:
     template <typename U>
     struct rebind {  // NOLINT
-        // Your code goes here
+        using other = CustomAllocator<U, Stats>;
     };
 
     using value_type = T;
-    // Your code goes here
+    using pointer = T*;
+    using const_pointer = const T*;
+    using reference = T&;
+    using const_reference = const T&;
+    using size_type = std::size_t;
+    using difference_type = std::ptrdiff_t;
+
+    using propagate_on_container_copy_assignment = std::false_type;
+    using propagate_on_container_move_assignment = std::true_type;
+    using propagate_on_container_swap = std::true_type;
+    using is_always_equal = std::false_type;
 
-    CustomAllocator();
-    CustomAllocator(const CustomAllocator& other) noexcept;
-    ~CustomAllocator();
+    CustomAllocator() : CustomAllocator(ArenaOptions()) {
+    }
+
+    explicit CustomAllocator(MonotonicArena) : CustomAllocator(MonotonicOptions()) {
+    }
+
+    explicit CustomAllocator(const ArenaOptions& options)
+        : CustomAllocator(new detail::PoolResource(options)) {
+    }
+
+    CustomAllocator(const CustomAllocator& other) noexcept
+        : Stats(other), resource_(other.resource_), pool_(other.pool_) {
+        resource_->AddRef();
+    }
 
     template <typename U>
-    explicit CustomAllocator(const CustomAllocator<U>& other) noexcept;
+    explicit CustomAllocator(const CustomAllocator<U, Stats>& other) noexcept
+        : CustomAllocator(other.resource_) {
+        resource_->AddRef();
+    }
 
-    T* allocate(size_t n) {  // NOLINT
-        // Your code goes here        
+    CustomAllocator& operator=(const CustomAllocator& other) noexcept {
+        other.resource_->AddRef();
+        detail::PoolResource::Release(resource_);
+        Stats::operator=(other);
+        resource_ = other.resource_;
+        pool_ = other.pool_;
+        return *this;
+    }
+
+    ~CustomAllocator() {
+        detail::PoolResource::Release(resource_);
+    }
+
+    T* allocate(size_type n) {  // NOLINT
+        if (n == 1) {
+            this->OnAllocateBlock(sizeof(T));
+            return static_cast<T*>(pool_->Allocate());
+        }
+        if (n > max_size()) {
+            throw std::bad_array_new_length();
+        }
+        const size_type bytes = n * sizeof(T);
+        if (detail::FitsSizeClass(bytes, alignof(T))) {
+            const size_type index = detail::SizeClassIndex(bytes);
+            this->OnAllocateSizeClass(index, bytes);
+            return static_cast<T*>(resource_->SizeClassPool(index).Allocate());
+        }
+        this->OnAllocateLarge(bytes);
+        return static_cast<T*>(::operator new(bytes, std::align_val_t(alignof(T))));
+    }
+
+    void deallocate(T* p, size_type n) noexcept {  // NOLINT
+        if (n == 1) {
+            this->OnDeallocateBlock(sizeof(T));
+            pool_->Deallocate(p);
+            return;
+        }
+        const size_type bytes = n * sizeof(T);
+        if (detail::FitsSizeClass(bytes, alignof(T))) {
+            const size_type index = detail::SizeClassIndex(bytes);
+            this->OnDeallocateSizeClass(index, bytes);
+            // The pool exists: it was created by the matching allocate.
+            resource_->SizeClassPool(index).Deallocate(p);
+            return;
+        }
+        this->OnDeallocateLarge(bytes);
+        ::operator delete(p, std::align_val_t(alignof(T)));
+    }
+
+    // count single-object blocks in one request, each passed to sink(T*) and
+    // freed later with deallocate(p, 1). Blocks handed to sink before an
+    // exception belong to the caller. Lets node-based containers take all
+    // the nodes of a bulk insert with at most one trip to the shared pool.
+    template <typename Sink>
+    void AllocateBatch(size_type count, Sink&& sink) {
+        pool_->AllocateBatch(count, [this, &sink](void* block) {
+            this->OnAllocateBlock(sizeof(T));
+            sink(static_cast<T*>(block));
+        });
     }
-    void deallocate(T* p, size_t n) {  // NOLINT
-        // Your code goes here
-    };
-    template <typename... Args>
-    void construct(pointer p, Args&&... args) {  // NOLINT
-        // Your code goes here
-    };
-    void destroy(pointer p) {  // NOLINT
-        // Your code goes here
-    };
 
-    template <typename K, typename U>
-    friend bool operator==(const CustomAllocator<K>& lhs, const CustomAllocator<U>& rhs) noexcept;
-    template <typename K, typename U>
-    friend bool operator!=(const CustomAllocator<K>& lhs, const CustomAllocator<U>& rhs) noexcept;
+    // Like AllocateBatch, but the blocks are carved one after another from
+    // the arena, so that they lie next to each other in memory. Used to
+    // compact node-based containers.
+    void AllocateFresh(T** blocks, size_type count) {
+        size_type done = 0;
+        try {
+            pool_->AllocateFresh(count, [this, blocks, &done](void* block) {
+                this->OnAllocateBlock(sizeof(T));
+                blocks[done++] = static_cast<T*>(block);
+            });
+        } catch (...) {
+            for (size_type i = 0; i < done; ++i) {
+                deallocate(blocks[i], 1);
+            }
+            throw;
+        }
+    }
+
+    template <typename U, typename... Args>
+    void construct(U* p, Args&&... args) {  // NOLINT
+        this->OnConstruct();
+        ::new (static_cast<void*>(p)) U(std::forward<Args>(args)...);
+    }
+
+    template <typename U>
+    void destroy(U* p) {  // NOLINT
+        this->OnDestroy();
+        p->~U();
+    }
+
+    size_type max_size() const noexcept {  // NOLINT
+        return std::numeric_limits<size_type>::max() / sizeof(T);
+    }
+
+    bool IsMonotonic() const noexcept {
+        return resource_->IsMonotonic();
+    }
+
+    AllocatorStats GetStats() const {
+        static_assert(Stats::kEnabled, "GetStats() needs CustomAllocator<T, CollectStats>");
+        return resource_->Snapshot();
+    }
+
+    void DumpStats(std::ostream& out) const {
+        out << GetStats();
+    }
+
+    template <typename K, typename U, typename S>
+    friend bool operator==(const CustomAllocator<K, S>& lhs,
+                           const CustomAllocator<U, S>& rhs) noexcept;
+    template <typename K, typename U, typename S>
+    friend bool operator!=(const CustomAllocator<K, S>& lhs,
+                           const CustomAllocator<U, S>& rhs) noexcept;
 
 private:
-    // Your code goes here
+    template <typename U, typename S>
+    friend class CustomAllocator;
+
+    static ArenaOptions MonotonicOptions() noexcept {
+        ArenaOptions options;
+        options.monotonic = true;
+        return options;
+    }
+
+    // Takes over the caller's reference to resource.
+    explicit CustomAllocator(detail::PoolResource* resource)
+        : CustomAllocator(resource, &PoolOf(resource)) {
+    }
+
+    CustomAllocator(detail::PoolResource* resource, detail::CentralPool* pool)
+        : Stats(resource, pool), resource_(resource), pool_(pool) {
+    }
+
+    // The pool is looked up once per allocator object, so allocate and
+    // deallocate go straight to it.
+    static detail::CentralPool& PoolOf(detail::PoolResource* resource) {
+        return resource->PoolFor(sizeof(T), alignof(T));
+    }
+
+    detail::PoolResource* resource_;
+    detail::CentralPool* pool_;
 };
 
-template <typename T, typename U>
-bool operator==(const CustomAllocator<T>& lhs, const CustomAllocator<U>& rhs) noexcept {
-    // Your code goes here
+template <typename T, typename U, typename S>
+bool operator==(const CustomAllocator<T, S>& lhs, const CustomAllocator<U, S>& rhs) noexcept {
+    return lhs.resource_ == rhs.resource_;
 }
 
-template <typename T, typename U>
-bool operator!=(const CustomAllocator<T>& lhs, const CustomAllocator<U>& rhs) noexcept {
-    // Your code goes here
-}
\ No newline at end of file
+template <typename T, typename U, typename S>
+bool operator!=(const CustomAllocator<T, S>& lhs, const CustomAllocator<U, S>& rhs) noexcept {
+    return !(lhs == rhs);
+}
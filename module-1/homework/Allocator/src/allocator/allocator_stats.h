@@ -0,0 +1,184 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <mutex>
+#include <ostream>
+#include <vector>
+
+#include "size_classes.h"
+
+// One pool of a CustomAllocator resource, i.e. one block size.
+struct SizeClassStats {
+    std::size_t block_size = 0;
+    std::size_t allocations = 0;
+    std::size_t live_blocks = 0;
+    // Freed blocks waiting for reuse, in the shared pool or in thread caches.
+    std::size_t free_blocks = 0;
+    std::size_t chunks = 0;
+};
+
+// A snapshot of everything a statistics-enabled CustomAllocator and the
+// allocators sharing its resource have done so far.
+struct AllocatorStats {
+    std::size_t live_bytes = 0;
+    std::size_t peak_bytes = 0;
+    std::size_t allocate_calls = 0;
+    std::size_t deallocate_calls = 0;
+    std::size_t construct_calls = 0;
+    std::size_t destroy_calls = 0;
+    // Requests for more than one object; small ones are served from the
+    // size-class pools, large ones by operator new.
+    std::size_t array_allocations = 0;
+    std::size_t large_live_bytes = 0;
+    std::size_t chunks = 0;
+    std::size_t free_blocks = 0;
+    std::vector<SizeClassStats> size_classes;
+};
+
+// How much pooled memory does not hold data. Internal fragmentation is the
+// share of live blocks lost to rounding requests up to the block size;
+// external is the share of carved blocks sitting free.
+struct FragmentationStats {
+    std::size_t requested_bytes = 0;
+    std::size_t live_block_bytes = 0;
+    std::size_t free_block_bytes = 0;
+    double internal = 0;
+    double external = 0;
+};
+
+inline FragmentationStats Fragmentation(const AllocatorStats& stats) {
+    FragmentationStats result;
+    result.requested_bytes = stats.live_bytes - stats.large_live_bytes;
+    for (const SizeClassStats& size_class : stats.size_classes) {
+        result.live_block_bytes += size_class.live_blocks * size_class.block_size;
+        result.free_block_bytes += size_class.free_blocks * size_class.block_size;
+    }
+    if (result.live_block_bytes > 0) {
+        result.internal = 1.0 - static_cast<double>(result.requested_bytes) /
+                                    static_cast<double>(result.live_block_bytes);
+    }
+    const std::size_t carved_bytes = result.live_block_bytes + result.free_block_bytes;
+    if (carved_bytes > 0) {
+        result.external =
+            static_cast<double>(result.free_block_bytes) / static_cast<double>(carved_bytes);
+    }
+    return result;
+}
+
+inline std::ostream& operator<<(std::ostream& out, const FragmentationStats& fragmentation) {
+    return out << "requested bytes:   " << fragmentation.requested_bytes << '\n'
+               << "live block bytes:  " << fragmentation.live_block_bytes << '\n'
+               << "free block bytes:  " << fragmentation.free_block_bytes << '\n'
+               << "internal:          " << fragmentation.internal * 100 << "%\n"
+               << "external:          " << fragmentation.external * 100 << "%\n";
+}
+
+inline std::ostream& operator<<(std::ostream& out, const AllocatorStats& stats) {
+    out << "live bytes:        " << stats.live_bytes << '\n'
+        << "peak bytes:        " << stats.peak_bytes << '\n'
+        << "allocate calls:    " << stats.allocate_calls << '\n'
+        << "deallocate calls:  " << stats.deallocate_calls << '\n'
+        << "construct calls:   " << stats.construct_calls << '\n'
+        << "destroy calls:     " << stats.destroy_calls << '\n'
+        << "array allocations: " << stats.array_allocations << '\n'
+        << "large live bytes:  " << stats.large_live_bytes << '\n'
+        << "arena chunks:      " << stats.chunks << '\n'
+        << "free-list length:  " << stats.free_blocks << '\n';
+    for (const SizeClassStats& size_class : stats.size_classes) {
+        out << "  " << size_class.block_size << " B: " << size_class.allocations
+            << " allocations, " << size_class.live_blocks << " live, " << size_class.free_blocks
+            << " free, " << size_class.chunks << " chunks\n";
+    }
+    return out << Fragmentation(stats);
+}
+
+namespace detail {
+
+struct SizeClassCounters {
+    explicit SizeClassCounters(const void* pool) : pool(pool) {
+    }
+
+    const void* const pool;
+    std::atomic<std::size_t> allocations{0};
+    std::atomic<std::size_t> deallocations{0};
+    SizeClassCounters* next = nullptr;
+};
+
+// The counters behind AllocatorStats. A resource only has them once a
+// statistics-enabled allocator has been made for it. Everything is relaxed:
+// the numbers are for reading, not for synchronizing on.
+class StatsCounters {
+public:
+    StatsCounters() = default;
+
+    StatsCounters(const StatsCounters&) = delete;
+    StatsCounters& operator=(const StatsCounters&) = delete;
+
+    ~StatsCounters() {
+        while (size_classes_ != nullptr) {
+            SizeClassCounters* next = size_classes_->next;
+            delete size_classes_;
+            size_classes_ = next;
+        }
+    }
+
+    // Called when an allocator is created, never on the allocate path.
+    SizeClassCounters& SizeClassOf(const void* pool) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (SizeClassCounters* it = size_classes_; it != nullptr; it = it->next) {
+            if (it->pool == pool) {
+                return *it;
+            }
+        }
+        SizeClassCounters* counters = new SizeClassCounters(pool);
+        counters->next = size_classes_;
+        size_classes_ = counters;
+        return *counters;
+    }
+
+    // Returns nullptr when nothing has been counted for pool.
+    const SizeClassCounters* FindSizeClass(const void* pool) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (SizeClassCounters* it = size_classes_; it != nullptr; it = it->next) {
+            if (it->pool == pool) {
+                return it;
+            }
+        }
+        return nullptr;
+    }
+
+    void OnAllocate(std::size_t bytes) noexcept {
+        allocate_calls.fetch_add(1, std::memory_order_relaxed);
+        const std::size_t live = live_bytes.fetch_add(bytes, std::memory_order_relaxed) + bytes;
+        std::size_t peak = peak_bytes.load(std::memory_order_relaxed);
+        while (peak < live &&
+               !peak_bytes.compare_exchange_weak(peak, live, std::memory_order_relaxed)) {
+        }
+    }
+
+    void OnDeallocate(std::size_t bytes) noexcept {
+        deallocate_calls.fetch_add(1, std::memory_order_relaxed);
+        live_bytes.fetch_sub(bytes, std::memory_order_relaxed);
+    }
+
+    // Size-class requests are counted by class index rather than by pool:
+    // the pool of a class is only known once the first request made it.
+    std::atomic<std::size_t> class_allocations[kSizeClassCount] = {};
+    std::atomic<std::size_t> class_deallocations[kSizeClassCount] = {};
+
+    std::atomic<std::size_t> live_bytes{0};
+    std::atomic<std::size_t> peak_bytes{0};
+    std::atomic<std::size_t> allocate_calls{0};
+    std::atomic<std::size_t> deallocate_calls{0};
+    std::atomic<std::size_t> construct_calls{0};
+    std::atomic<std::size_t> destroy_calls{0};
+    std::atomic<std::size_t> array_allocations{0};
+    std::atomic<std::size_t> large_live_bytes{0};
+
+private:
+    std::mutex mutex_;
+    SizeClassCounters* size_classes_ = nullptr;
+};
+
+}  // namespace detail
@@ -0,0 +1,27 @@
+#pragma once
+
+#include <cstddef>
+
+// How the arenas behind a CustomAllocator are laid out. Fixed when the
+// allocator is created and shared by its copies and rebinds.
+struct ArenaOptions {
+    // Never reuse freed blocks; see kMonotonicArena.
+    bool monotonic = false;
+    // Start every chunk on a cache line, so that the first blocks of a chunk
+    // do not share a line with whatever the system allocator put before it.
+    bool cache_line_chunks = false;
+    // Round single-object blocks up to whole cache lines, so that nodes owned
+    // by different threads never share one. Costs memory for small nodes.
+    bool pad_to_cache_line = false;
+    // Take chunks as 2 MiB aligned anonymous mappings marked MADV_HUGEPAGE,
+    // so that a traversal touches far fewer pages. Linux only; elsewhere the
+    // option is ignored.
+    bool huge_pages = false;
+};
+
+namespace detail {
+
+constexpr std::size_t kCacheLineSize = 64;
+constexpr std::size_t kHugePageSize = std::size_t(2) << 20;
+
+}  // namespace detail
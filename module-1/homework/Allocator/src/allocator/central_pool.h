@@ -0,0 +1,170 @@
+#pragma once
+
+#include <cstddef>
+#include <mutex>
+#include <new>
+
+#include "arena_options.h"
+#include "fixed_block_pool.h"
+#include "thread_cache.h"
+
+namespace detail {
+
+struct PoolUsage {
+    std::size_t chunks;
+    std::size_t carved_blocks;
+};
+
+// A FixedBlockPool that any number of threads may use at once. Each thread
+// allocates from and frees into its own ThreadCache; the shared pool, behind
+// a mutex, is only visited to move kBatchSize blocks at a time, so a thread
+// takes the lock at most once per kBatchSize operations.
+//
+// A cache never holds more than 2 * kBatchSize blocks: a free that fills it
+// hands the older half back. A thread that exits leaves its cache to the next
+// thread that gets its ThreadIndex. Threads without an index go straight to
+// the shared pool under the lock.
+//
+// A monotonic pool ignores Deallocate, so its blocks are only ever carved
+// from the chunks and go back to the system with the pool.
+class CentralPool {
+public:
+    static constexpr std::size_t kBatchSize = 32;
+
+    CentralPool(std::size_t block_size, std::size_t alignment, const ArenaOptions& options)
+        : pool_(block_size, alignment, options), monotonic_(options.monotonic) {
+    }
+
+    CentralPool(const CentralPool&) = delete;
+    CentralPool& operator=(const CentralPool&) = delete;
+
+    ~CentralPool() {
+        for (ThreadCache* cache : caches_) {
+            delete cache;
+        }
+    }
+
+    void* Allocate() {
+        ThreadCache* cache = CacheOfThisThread();
+        if (cache == nullptr) {
+            std::lock_guard<std::mutex> lock(mutex_);
+            return pool_.Allocate();
+        }
+        if (cache->head == nullptr) {
+            Refill(cache);
+        }
+        FreeBlock* block = cache->head;
+        cache->head = block->next;
+        --cache->count;
+        return block;
+    }
+
+    void Deallocate(void* p) noexcept {
+        if (monotonic_) {
+            return;
+        }
+        ThreadCache* cache = CacheOfThisThread();
+        if (cache == nullptr) {
+            std::lock_guard<std::mutex> lock(mutex_);
+            pool_.Deallocate(p);
+            return;
+        }
+        FreeBlock* block = static_cast<FreeBlock*>(p);
+        block->next = cache->head;
+        cache->head = block;
+        if (++cache->count == 2 * kBatchSize) {
+            Drain(cache);
+        }
+    }
+
+    // Passes count blocks to sink: first whatever this thread's cache holds,
+    // then the rest from the shared pool in a single locked visit.
+    template <typename Sink>
+    void AllocateBatch(std::size_t count, Sink&& sink) {
+        if (ThreadCache* cache = CacheOfThisThread()) {
+            for (; count > 0 && cache->head != nullptr; --count) {
+                FreeBlock* block = cache->head;
+                cache->head = block->next;
+                --cache->count;
+                sink(block);
+            }
+        }
+        if (count == 0) {
+            return;
+        }
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (; count > 0; --count) {
+            sink(pool_.Allocate());
+        }
+    }
+
+    // Passes count freshly carved, adjacent blocks to sink, bypassing the
+    // free lists and the thread cache. They are freed with Deallocate.
+    template <typename Sink>
+    void AllocateFresh(std::size_t count, Sink&& sink) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (std::size_t i = 0; i < count; ++i) {
+            sink(pool_.Carve());
+        }
+    }
+
+    std::size_t BlockSize() const noexcept {
+        return pool_.BlockSize();
+    }
+
+    std::size_t Alignment() const noexcept {
+        return pool_.Alignment();
+    }
+
+    // Read under the lock, so it is a consistent snapshot of the shared pool.
+    PoolUsage Usage() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return PoolUsage{pool_.ChunkCount(), pool_.CarvedBlocks()};
+    }
+
+private:
+    // Created on the thread's first use of this pool. When that allocation
+    // fails the thread simply goes on using the locked path.
+    ThreadCache* CacheOfThisThread() noexcept {
+        const std::size_t index = ThreadIndex::Current();
+        if (index == ThreadIndex::kNone) {
+            return nullptr;
+        }
+        if (caches_[index] == nullptr) {
+            caches_[index] = new (std::nothrow) ThreadCache();
+        }
+        return caches_[index];
+    }
+
+    void Refill(ThreadCache* cache) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        cache->head = pool_.AllocateBatch(kBatchSize);
+        cache->count = kBatchSize;
+    }
+
+    // The most recently freed blocks are the likeliest to be warm, so the
+    // ones further down the chain go back.
+    void Drain(ThreadCache* cache) noexcept {
+        FreeBlock* last = cache->head;
+        for (std::size_t i = 1; i < kBatchSize; ++i) {
+            last = last->next;
+        }
+        FreeBlock* first = last->next;
+        last->next = nullptr;
+        cache->count = kBatchSize;
+
+        last = first;
+        while (last->next != nullptr) {
+            last = last->next;
+        }
+        std::lock_guard<std::mutex> lock(mutex_);
+        pool_.DeallocateBatch(first, last);
+    }
+
+    FixedBlockPool pool_;
+    const bool monotonic_;
+    std::mutex mutex_;
+    ThreadCache* caches_[ThreadIndex::kMaxThreads] = {};
+};
+
+}  // namespace detail
@@ -0,0 +1,199 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <new>
+
+#include "arena_options.h"
+#include "huge_pages.h"
+
+namespace detail {
+
+// The link a free block stores in its own first bytes.
+struct FreeBlock {
+    FreeBlock* next;
+};
+
+// Hands out blocks of one fixed size. Memory comes from large chunks carved
+// front to back; freed blocks go on an intrusive free list threaded through
+// the blocks themselves, so both Allocate and Deallocate are a handful of
+// instructions and touch the system allocator only when a chunk runs out.
+//
+// Of the ArenaOptions, cache_line_chunks and huge_pages decide where chunks
+// come from; the block layout is the caller's.
+class FixedBlockPool {
+public:
+    FixedBlockPool(std::size_t block_size, std::size_t alignment,
+                   const ArenaOptions& options = ArenaOptions())
+        : block_size_(BlockSizeFor(block_size, alignment)),
+          alignment_(AlignmentFor(alignment)),
+          chunk_alignment_(options.cache_line_chunks ? std::max(alignment_, kCacheLineSize)
+                                                     : alignment_),
+          huge_pages_(options.huge_pages && kHugePagesSupported) {
+    }
+
+    FixedBlockPool(const FixedBlockPool&) = delete;
+    FixedBlockPool& operator=(const FixedBlockPool&) = delete;
+
+    ~FixedBlockPool() {
+        Release();
+    }
+
+    void* Allocate() {
+        if (free_ != nullptr) {
+            FreeBlock* block = free_;
+            free_ = block->next;
+            return block;
+        }
+        return Carve();
+    }
+
+    // A block that has never been handed out, ignoring the free list: blocks
+    // carved one after another are adjacent except across chunk boundaries.
+    void* Carve() {
+        if (cursor_ == end_) {
+            Grow();
+        }
+        void* block = cursor_;
+        cursor_ += block_size_;
+        return block;
+    }
+
+    void Deallocate(void* p) noexcept {
+        FreeBlock* block = static_cast<FreeBlock*>(p);
+        block->next = free_;
+        free_ = block;
+    }
+
+    // Takes count blocks at once as a null-terminated chain. The chain keeps
+    // carving order, so blocks fresh from a chunk come out at ascending
+    // addresses and a list built from them is walked front to back in memory.
+    FreeBlock* AllocateBatch(std::size_t count) {
+        FreeBlock* head = nullptr;
+        FreeBlock** tail = &head;
+        for (std::size_t i = 0; i < count; ++i) {
+            FreeBlock* block = static_cast<FreeBlock*>(Allocate());
+            *tail = block;
+            tail = &block->next;
+        }
+        *tail = nullptr;
+        return head;
+    }
+
+    // Gives back the chain first..last in one splice.
+    void DeallocateBatch(FreeBlock* first, FreeBlock* last) noexcept {
+        last->next = free_;
+        free_ = first;
+    }
+
+    // Returns every chunk to the system. Outstanding blocks become invalid.
+    void Release() noexcept {
+        while (chunks_ != nullptr) {
+            Chunk* next = chunks_->next;
+            FreeChunk(chunks_);
+            chunks_ = next;
+        }
+        free_ = nullptr;
+        cursor_ = nullptr;
+        end_ = nullptr;
+        next_chunk_blocks_ = kFirstChunkBlocks;
+        chunk_count_ = 0;
+        chunk_blocks_ = 0;
+    }
+
+    std::size_t BlockSize() const noexcept {
+        return block_size_;
+    }
+
+    std::size_t Alignment() const noexcept {
+        return alignment_;
+    }
+
+    std::size_t ChunkCount() const noexcept {
+        return chunk_count_;
+    }
+
+    // Blocks handed out at least once, whether in use or on the free list now.
+    std::size_t CarvedBlocks() const noexcept {
+        return chunk_blocks_ - static_cast<std::size_t>(end_ - cursor_) / block_size_;
+    }
+
+    // The layout a pool created for (block_size, alignment) actually uses:
+    // every block must be able to hold a free-list link.
+    static std::size_t AlignmentFor(std::size_t alignment) noexcept {
+        return std::max(alignment, alignof(FreeBlock));
+    }
+
+    static std::size_t BlockSizeFor(std::size_t block_size, std::size_t alignment) noexcept {
+        return RoundUp(std::max(block_size, sizeof(FreeBlock)), AlignmentFor(alignment));
+    }
+
+private:
+    // Chunks are chained through a header at their start, so the pool needs
+    // no bookkeeping allocations of its own.
+    struct Chunk {
+        Chunk* next;
+        std::size_t bytes;
+    };
+
+    // Chunks start small so that short-lived lists stay cheap, then double up
+    // to a cap: large enough that the system allocator is rarely called, small
+    // enough that a freshly mapped chunk does not fault in megabytes at once.
+    static constexpr std::size_t kFirstChunkBlocks = 64;
+    static constexpr std::size_t kMaxChunkBytes = std::size_t(1) << 20;
+
+    static std::size_t RoundUp(std::size_t value, std::size_t alignment) noexcept {
+        return (value + alignment - 1) / alignment * alignment;
+    }
+
+    // A huge-page chunk is rounded up to whole huge pages and the extra room
+    // filled with blocks, so in that mode every chunk is at least 2 MiB.
+    void Grow() {
+        const std::size_t header = RoundUp(sizeof(Chunk), alignment_);
+        std::size_t bytes = header + next_chunk_blocks_ * block_size_;
+        char* memory;
+        if (huge_pages_) {
+            bytes = RoundUp(bytes, kHugePageSize);
+            memory = static_cast<char*>(MapHugePages(bytes));
+        } else {
+            memory = static_cast<char*>(::operator new(bytes, std::align_val_t(chunk_alignment_)));
+        }
+        const std::size_t blocks = (bytes - header) / block_size_;
+
+        Chunk* chunk = reinterpret_cast<Chunk*>(memory);
+        chunk->next = chunks_;
+        chunk->bytes = bytes;
+        chunks_ = chunk;
+        ++chunk_count_;
+        chunk_blocks_ += blocks;
+        cursor_ = memory + header;
+        end_ = cursor_ + blocks * block_size_;
+
+        if ((next_chunk_blocks_ * 2) * block_size_ <= kMaxChunkBytes) {
+            next_chunk_blocks_ *= 2;
+        }
+    }
+
+    void FreeChunk(Chunk* chunk) noexcept {
+        if (huge_pages_) {
+            UnmapHugePages(chunk, chunk->bytes);
+        } else {
+            ::operator delete(chunk, std::align_val_t(chunk_alignment_));
+        }
+    }
+
+    const std::size_t block_size_;
+    const std::size_t alignment_;
+    const std::size_t chunk_alignment_;
+    const bool huge_pages_;
+
+    FreeBlock* free_ = nullptr;
+    char* cursor_ = nullptr;
+    char* end_ = nullptr;
+    Chunk* chunks_ = nullptr;
+    std::size_t next_chunk_blocks_ = kFirstChunkBlocks;
+    std::size_t chunk_count_ = 0;
+    std::size_t chunk_blocks_ = 0;
+};
+
+}  // namespace detail
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <new>
+
+#include "arena_options.h"
+
+#ifdef __linux__
+#include <sys/mman.h>
+#endif
+
+namespace detail {
+
+#ifdef __linux__
+constexpr bool kHugePagesSupported = true;
+#else
+constexpr bool kHugePagesSupported = false;
+#endif
+
+// Maps bytes, a multiple of kHugePageSize, at a kHugePageSize boundary and
+// asks the kernel to back it with transparent huge pages. Whether it does
+// depends on the system's THP setting; the memory is usable either way.
+inline void* MapHugePages(std::size_t bytes) {
+#ifdef __linux__
+    const std::size_t padded = bytes + kHugePageSize;
+    void* mapping =
+        mmap(nullptr, padded, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (mapping == MAP_FAILED) {
+        throw std::bad_alloc();
+    }
+    // Over-map by one huge page and trim both ends to get the alignment.
+    const std::uintptr_t begin = reinterpret_cast<std::uintptr_t>(mapping);
+    const std::uintptr_t aligned = (begin + kHugePageSize - 1) & ~(kHugePageSize - 1);
+    if (aligned != begin) {
+        munmap(mapping, aligned - begin);
+    }
+    const std::size_t tail = padded - (aligned - begin) - bytes;
+    if (tail != 0) {
+        munmap(reinterpret_cast<void*>(aligned + bytes), tail);
+    }
+    madvise(reinterpret_cast<void*>(aligned), bytes, MADV_HUGEPAGE);
+    return reinterpret_cast<void*>(aligned);
+#else
+    (void)bytes;
+    throw std::bad_alloc();
+#endif
+}
+
+inline void UnmapHugePages(void* p, std::size_t bytes) noexcept {
+#ifdef __linux__
+    munmap(p, bytes);
+#else
+    (void)p;
+    (void)bytes;
+#endif
+}
+
+}  // namespace detail
@@ -0,0 +1,177 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <mutex>
+
+#include "allocator_stats.h"
+#include "arena_options.h"
+#include "central_pool.h"
+#include "fixed_block_pool.h"
+#include "size_classes.h"
+
+namespace detail {
+
+// State shared by an allocator, its copies and its rebinds, which may live on
+// different threads. Each distinct block layout gets one CentralPool, created
+// the first time an allocator for that layout is made, so List<T>'s node
+// allocator and the value allocator it was rebound from draw from separate
+// pools of one resource.
+//
+// A monotonic resource never takes blocks back: deallocation is a no-op and
+// the memory is returned all at once when the resource is destroyed.
+class PoolResource {
+public:
+    explicit PoolResource(const ArenaOptions& options) : options_(options) {
+    }
+
+    PoolResource(const PoolResource&) = delete;
+    PoolResource& operator=(const PoolResource&) = delete;
+
+    ~PoolResource() {
+        delete stats_;
+        PoolEntry* entry = pools_.load(std::memory_order_relaxed);
+        while (entry != nullptr) {
+            PoolEntry* next = entry->next;
+            delete entry;
+            entry = next;
+        }
+    }
+
+    void AddRef() noexcept {
+        refs_.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    // Drops one reference and destroys the resource, with every chunk it
+    // owns, when it was the last one.
+    static void Release(PoolResource* resource) noexcept {
+        if (resource->refs_.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+            delete resource;
+        }
+    }
+
+    bool IsMonotonic() const noexcept {
+        return options_.monotonic;
+    }
+
+    // The pool for single objects of this layout, padded to whole cache
+    // lines if the options say so. Called when an allocator is created or
+    // rebound, never on the allocate path; once the pool exists it is found
+    // without taking the lock, since rebinding is common in allocate_shared
+    // style code.
+    CentralPool& PoolFor(std::size_t block_size, std::size_t alignment) {
+        if (options_.pad_to_cache_line && alignment < kCacheLineSize) {
+            alignment = kCacheLineSize;
+        }
+        return PoolForLayout(block_size, alignment);
+    }
+
+    // The pool of a size class, created by the first request in that class.
+    // After that this is a single acquire load.
+    CentralPool& SizeClassPool(std::size_t index) {
+        CentralPool* pool = size_class_pools_[index].load(std::memory_order_acquire);
+        if (pool == nullptr) {
+            pool = &PoolForLayout(SizeClassBytes(index), kSizeClassAlignment);
+            size_class_pools_[index].store(pool, std::memory_order_release);
+        }
+        return *pool;
+    }
+
+    // Created by the first statistics-enabled allocator for this resource.
+    StatsCounters& Stats() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (stats_ == nullptr) {
+            stats_ = new StatsCounters();
+        }
+        return *stats_;
+    }
+
+    AllocatorStats Snapshot() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        AllocatorStats result;
+        if (stats_ == nullptr) {
+            return result;
+        }
+        result.live_bytes = stats_->live_bytes.load(std::memory_order_relaxed);
+        result.peak_bytes = stats_->peak_bytes.load(std::memory_order_relaxed);
+        result.allocate_calls = stats_->allocate_calls.load(std::memory_order_relaxed);
+        result.deallocate_calls = stats_->deallocate_calls.load(std::memory_order_relaxed);
+        result.construct_calls = stats_->construct_calls.load(std::memory_order_relaxed);
+        result.destroy_calls = stats_->destroy_calls.load(std::memory_order_relaxed);
+        result.array_allocations = stats_->array_allocations.load(std::memory_order_relaxed);
+        result.large_live_bytes = stats_->large_live_bytes.load(std::memory_order_relaxed);
+
+        for (PoolEntry* entry = pools_.load(std::memory_order_relaxed); entry != nullptr;
+             entry = entry->next) {
+            const PoolUsage usage = entry->pool.Usage();
+            SizeClassStats size_class;
+            size_class.block_size = entry->pool.BlockSize();
+            size_class.chunks = usage.chunks;
+            std::size_t deallocations = 0;
+            if (const SizeClassCounters* counters = stats_->FindSizeClass(&entry->pool)) {
+                size_class.allocations = counters->allocations.load(std::memory_order_relaxed);
+                deallocations = counters->deallocations.load(std::memory_order_relaxed);
+            }
+            for (std::size_t i = 0; i < kSizeClassCount; ++i) {
+                if (size_class_pools_[i].load(std::memory_order_acquire) == &entry->pool) {
+                    size_class.allocations +=
+                        stats_->class_allocations[i].load(std::memory_order_relaxed);
+                    deallocations += stats_->class_deallocations[i].load(std::memory_order_relaxed);
+                }
+            }
+            size_class.live_blocks = size_class.allocations - deallocations;
+            // Every carved block that is not live sits on a free list, unless
+            // the arena never reuses them.
+            if (!options_.monotonic && usage.carved_blocks > size_class.live_blocks) {
+                size_class.free_blocks = usage.carved_blocks - size_class.live_blocks;
+            }
+            result.chunks += size_class.chunks;
+            result.free_blocks += size_class.free_blocks;
+            result.size_classes.push_back(size_class);
+        }
+        return result;
+    }
+
+private:
+    struct PoolEntry {
+        CentralPool pool;
+        PoolEntry* next;
+    };
+
+    // Layouts that round to the same block share a pool. Entries are only
+    // ever pushed at the head and live as long as the resource, so readers can
+    // walk the list without the lock.
+    CentralPool& PoolForLayout(std::size_t block_size, std::size_t alignment) {
+        const std::size_t size = FixedBlockPool::BlockSizeFor(block_size, alignment);
+        const std::size_t align = FixedBlockPool::AlignmentFor(alignment);
+        if (CentralPool* pool = FindPool(pools_.load(std::memory_order_acquire), size, align)) {
+            return *pool;
+        }
+        std::lock_guard<std::mutex> lock(mutex_);
+        PoolEntry* head = pools_.load(std::memory_order_relaxed);
+        if (CentralPool* pool = FindPool(head, size, align)) {
+            return *pool;
+        }
+        PoolEntry* entry = new PoolEntry{CentralPool(block_size, alignment, options_), head};
+        pools_.store(entry, std::memory_order_release);
+        return entry->pool;
+    }
+
+    static CentralPool* FindPool(PoolEntry* entry, std::size_t size, std::size_t align) noexcept {
+        for (; entry != nullptr; entry = entry->next) {
+            if (entry->pool.BlockSize() == size && entry->pool.Alignment() == align) {
+                return &entry->pool;
+            }
+        }
+        return nullptr;
+    }
+
+    const ArenaOptions options_;
+    std::mutex mutex_;
+    std::atomic<PoolEntry*> pools_{nullptr};
+    StatsCounters* stats_ = nullptr;
+    std::atomic<CentralPool*> size_class_pools_[kSizeClassCount] = {};
+    std::atomic<std::size_t> refs_{1};
+};
+
+}  // namespace detail
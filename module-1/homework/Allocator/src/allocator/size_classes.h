@@ -0,0 +1,48 @@
+#pragma once
+
+#include <cstddef>
+
+namespace detail {
+
+// Segregated size classes for requests of more than one object. Up to 128
+// bytes the classes are 16 bytes apart; above that every power-of-two range
+// is split into four, so rounding never wastes more than a fifth of a block.
+// Requests above kMaxSizeClassBytes or with stricter alignment than the
+// classes give go to operator new.
+constexpr std::size_t kSizeClassCount = 32;
+constexpr std::size_t kMaxSizeClassBytes = 8192;
+constexpr std::size_t kSizeClassAlignment = 16;
+
+constexpr bool FitsSizeClass(std::size_t bytes, std::size_t alignment) noexcept {
+    return bytes <= kMaxSizeClassBytes && alignment <= kSizeClassAlignment;
+}
+
+constexpr std::size_t FloorLog2(std::size_t value) noexcept {
+    std::size_t log = 0;
+    while (value >>= 1) {
+        ++log;
+    }
+    return log;
+}
+
+constexpr std::size_t SizeClassIndex(std::size_t bytes) noexcept {
+    if (bytes <= 128) {
+        return bytes == 0 ? 0 : (bytes - 1) / 16;
+    }
+    const std::size_t log = FloorLog2(bytes - 1);
+    return 8 + (log - 7) * 4 + (((bytes - 1) >> (log - 2)) & 3);
+}
+
+constexpr std::size_t SizeClassBytes(std::size_t index) noexcept {
+    if (index < 8) {
+        return (index + 1) * 16;
+    }
+    const std::size_t log = (index - 8) / 4 + 7;
+    return (std::size_t(1) << log) + ((index - 8) % 4 + 1) * (std::size_t(1) << (log - 2));
+}
+
+static_assert(SizeClassBytes(kSizeClassCount - 1) == kMaxSizeClassBytes);
+static_assert(SizeClassIndex(kMaxSizeClassBytes) == kSizeClassCount - 1);
+static_assert(SizeClassIndex(129) == 8 && SizeClassBytes(8) == 160);
+
+}  // namespace detail
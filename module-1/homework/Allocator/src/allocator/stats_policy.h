@@ -0,0 +1,100 @@
+#pragma once
+
+#include <cstddef>
+
+#include "allocator_stats.h"
+#include "central_pool.h"
+#include "pool_resource.h"
+
+// Statistics policies for CustomAllocator, which derives from the one it is
+// given. NoStats is empty and its hooks are empty inline functions, so an
+// allocator without statistics carries no counters and does no counting.
+class NoStats {
+public:
+    static constexpr bool kEnabled = false;
+
+protected:
+    NoStats(detail::PoolResource*, detail::CentralPool*) noexcept {
+    }
+
+    void OnAllocateBlock(std::size_t) noexcept {
+    }
+
+    void OnDeallocateBlock(std::size_t) noexcept {
+    }
+
+    void OnAllocateSizeClass(std::size_t, std::size_t) noexcept {
+    }
+
+    void OnDeallocateSizeClass(std::size_t, std::size_t) noexcept {
+    }
+
+    void OnAllocateLarge(std::size_t) noexcept {
+    }
+
+    void OnDeallocateLarge(std::size_t) noexcept {
+    }
+
+    void OnConstruct() noexcept {
+    }
+
+    void OnDestroy() noexcept {
+    }
+};
+
+// Counts into the resource, so copies and rebinds add up to one set of
+// numbers. Costs a few relaxed atomic adds per call.
+class CollectStats {
+public:
+    static constexpr bool kEnabled = true;
+
+protected:
+    CollectStats(detail::PoolResource* resource, detail::CentralPool* pool)
+        : stats_(&resource->Stats()), size_class_(&stats_->SizeClassOf(pool)) {
+    }
+
+    // A single object from the allocator's own pool.
+    void OnAllocateBlock(std::size_t bytes) noexcept {
+        stats_->OnAllocate(bytes);
+        size_class_->allocations.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    void OnDeallocateBlock(std::size_t bytes) noexcept {
+        stats_->OnDeallocate(bytes);
+        size_class_->deallocations.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    void OnAllocateSizeClass(std::size_t index, std::size_t bytes) noexcept {
+        stats_->OnAllocate(bytes);
+        stats_->array_allocations.fetch_add(1, std::memory_order_relaxed);
+        stats_->class_allocations[index].fetch_add(1, std::memory_order_relaxed);
+    }
+
+    void OnDeallocateSizeClass(std::size_t index, std::size_t bytes) noexcept {
+        stats_->OnDeallocate(bytes);
+        stats_->class_deallocations[index].fetch_add(1, std::memory_order_relaxed);
+    }
+
+    void OnAllocateLarge(std::size_t bytes) noexcept {
+        stats_->OnAllocate(bytes);
+        stats_->array_allocations.fetch_add(1, std::memory_order_relaxed);
+        stats_->large_live_bytes.fetch_add(bytes, std::memory_order_relaxed);
+    }
+
+    void OnDeallocateLarge(std::size_t bytes) noexcept {
+        stats_->OnDeallocate(bytes);
+        stats_->large_live_bytes.fetch_sub(bytes, std::memory_order_relaxed);
+    }
+
+    void OnConstruct() noexcept {
+        stats_->construct_calls.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    void OnDestroy() noexcept {
+        stats_->destroy_calls.fetch_add(1, std::memory_order_relaxed);
+    }
+
+private:
+    detail::StatsCounters* stats_;
+    detail::SizeClassCounters* size_class_;
+};
@@ -0,0 +1,72 @@
+#pragma once
+
+#include <cstddef>
+#include <mutex>
+
+#include "arena_options.h"
+#include "fixed_block_pool.h"
+
+namespace detail {
+
+// Small dense ids for live threads, so per-thread state can sit in plain
+// arrays instead of a map. An id is handed to the next new thread once its
+// owner exits; threads beyond kMaxThreads get kNone.
+class ThreadIndex {
+public:
+    static constexpr std::size_t kMaxThreads = 64;
+    static constexpr std::size_t kNone = kMaxThreads;
+
+    ThreadIndex(const ThreadIndex&) = delete;
+    ThreadIndex& operator=(const ThreadIndex&) = delete;
+
+    static std::size_t Current() noexcept {
+        thread_local ThreadIndex index;
+        return index.id_;
+    }
+
+private:
+    struct Registry {
+        std::mutex mutex;
+        std::size_t released[kMaxThreads];
+        std::size_t released_count = 0;
+        std::size_t next = 0;
+    };
+
+    // The registry is built before the first ThreadIndex, so it outlives the
+    // main thread's one at exit.
+    static Registry& GetRegistry() noexcept {
+        static Registry registry;
+        return registry;
+    }
+
+    ThreadIndex() noexcept {
+        Registry& registry = GetRegistry();
+        std::lock_guard<std::mutex> lock(registry.mutex);
+        if (registry.released_count > 0) {
+            id_ = registry.released[--registry.released_count];
+        } else if (registry.next < kMaxThreads) {
+            id_ = registry.next++;
+        }
+    }
+
+    ~ThreadIndex() {
+        if (id_ == kNone) {
+            return;
+        }
+        Registry& registry = GetRegistry();
+        std::lock_guard<std::mutex> lock(registry.mutex);
+        registry.released[registry.released_count++] = id_;
+    }
+
+    std::size_t id_ = kNone;
+};
+
+// One thread's stock of blocks from one pool. Only the thread holding the
+// matching ThreadIndex touches it, so it needs no synchronization; the line
+// alignment keeps neighbouring threads' caches from sharing a cache line.
+struct alignas(kCacheLineSize) ThreadCache {
+    FreeBlock* head = nullptr;
+    std::size_t count = 0;
+};
+
+}  // namespace detail
@@ -0,0 +1,324 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <iterator>
+#include <memory>
+#include <new>
+#include <optional>
+#include <utility>
+
+#include "../allocator/allocator.h"
+
+namespace task {
+
+// A multi-producer, multi-consumer FIFO queue: Michael and Scott's lock-free
+// linked queue, with hazard pointers deciding when a dequeued node may go
+// back to the allocator. Every member may be called from any number of
+// threads at once, except construction and destruction.
+//
+// The queue always holds one dummy node in front of the elements; PopFront
+// moves the value out of the node after the dummy, which then becomes the
+// new dummy. The old dummy is retired, and freed once no thread has it in a
+// hazard pointer. Nodes come from Allocator, which has to be usable from
+// several threads at once; CustomAllocator is.
+template <typename T, typename Allocator = CustomAllocator<T>>
+class ConcurrentQueue {
+public:
+    using value_type = T;
+    using allocator_type = Allocator;
+    using size_type = std::size_t;
+
+    ConcurrentQueue() : ConcurrentQueue(Allocator()) {
+    }
+
+    explicit ConcurrentQueue(const Allocator& alloc) : alloc_(alloc) {
+        Node* dummy = AllocateNode();
+        head_.store(dummy, std::memory_order_relaxed);
+        tail_.store(dummy, std::memory_order_relaxed);
+    }
+
+    ConcurrentQueue(const ConcurrentQueue&) = delete;
+    ConcurrentQueue& operator=(const ConcurrentQueue&) = delete;
+
+    ~ConcurrentQueue() {
+        Node* dummy = head_.load(std::memory_order_relaxed);
+        for (Node* node = dummy->next.load(std::memory_order_relaxed); node != nullptr;) {
+            Node* next = node->next.load(std::memory_order_relaxed);
+            node_traits::destroy(alloc_, node->Value());
+            DeallocateNode(node);
+            node = next;
+        }
+        DeallocateNode(dummy);
+        for (HazardRecord& record : records_) {
+            FreeRetired(record);
+        }
+        for (HazardRecord* record = overflow_.load(std::memory_order_relaxed);
+             record != nullptr;) {
+            HazardRecord* next = record->next;
+            FreeRetired(*record);
+            delete record;
+            record = next;
+        }
+    }
+
+    void PushBack(const T& value) {
+        EmplaceBack(value);
+    }
+
+    void PushBack(T&& value) {
+        EmplaceBack(std::move(value));
+    }
+
+    template <typename... Args>
+    void EmplaceBack(Args&&... args) {
+        Node* node = AllocateNode();
+        try {
+            node_traits::construct(alloc_, node->Value(), std::forward<Args>(args)...);
+        } catch (...) {
+            DeallocateNode(node);
+            throw;
+        }
+
+        RecordLock record(*this);
+        while (true) {
+            Node* tail = Protect(record->hazards[0], tail_);
+            Node* next = tail->next.load();
+            if (tail != tail_.load()) {
+                continue;
+            }
+            if (next != nullptr) {
+                // Another push linked its node but has not swung the tail yet.
+                tail_.compare_exchange_weak(tail, next);
+                continue;
+            }
+            if (tail->next.compare_exchange_weak(next, node)) {
+                tail_.compare_exchange_strong(tail, node);
+                return;
+            }
+        }
+    }
+
+    // Removes and returns the front element, or returns nothing if the queue
+    // is empty at the moment of the call.
+    std::optional<T> PopFront() {
+        RecordLock record(*this);
+        while (true) {
+            Node* head = Protect(record->hazards[0], head_);
+            Node* tail = tail_.load();
+            Node* next = head->next.load();
+            record->hazards[1].store(next);
+            if (head != head_.load()) {
+                continue;
+            }
+            if (next == nullptr) {
+                return std::nullopt;
+            }
+            if (head == tail) {
+                tail_.compare_exchange_weak(tail, next);
+                continue;
+            }
+            if (head_.compare_exchange_weak(head, next)) {
+                // next is the new dummy. Its value belongs to this thread alone,
+                // and the hazard pointer keeps the node alive until it is moved.
+                std::optional<T> result(std::move(*next->Value()));
+                node_traits::destroy(alloc_, next->Value());
+                record->hazards[1].store(nullptr);
+                Retire(*record, head);
+                return result;
+            }
+        }
+    }
+
+    allocator_type GetAllocator() const noexcept {
+        return alloc_;
+    }
+
+private:
+    struct Node {
+        T* Value() noexcept {
+            return std::launder(reinterpret_cast<T*>(&storage));
+        }
+
+        std::atomic<Node*> next{nullptr};
+        // Links the node into a hazard record's retired list once dequeued.
+        Node* retired_next = nullptr;
+        alignas(T) unsigned char storage[sizeof(T)];
+    };
+
+    using node_allocator = typename std::allocator_traits<Allocator>::template rebind_alloc<Node>;
+    using node_traits = std::allocator_traits<node_allocator>;
+
+    static constexpr std::size_t kHazardsPerThread = 2;
+    // Retired nodes a record collects before it looks for ones to free: twice
+    // the hazard pointers of kMaxThreads threads, so that a scan frees at
+    // least half of them unless threads without an index are busy too.
+    static constexpr std::size_t kRetireThreshold =
+        2 * kHazardsPerThread * ::detail::ThreadIndex::kMaxThreads;
+
+    // A thread takes a record for the span of one operation. Records are
+    // never given back to the system before the queue, so a hazard scan can
+    // walk them without any reclamation of its own.
+    struct alignas(::detail::kCacheLineSize) HazardRecord {
+        std::atomic<bool> active{false};
+        std::atomic<Node*> hazards[kHazardsPerThread] = {};
+        // Owned by whichever thread holds the record.
+        Node* retired = nullptr;
+        std::size_t retired_count = 0;
+        HazardRecord* next = nullptr;
+    };
+
+    class RecordLock {
+    public:
+        explicit RecordLock(ConcurrentQueue& queue) : record_(queue.AcquireRecord()) {
+        }
+
+        RecordLock(const RecordLock&) = delete;
+        RecordLock& operator=(const RecordLock&) = delete;
+
+        ~RecordLock() {
+            for (std::atomic<Node*>& hazard : record_->hazards) {
+                hazard.store(nullptr, std::memory_order_release);
+            }
+            record_->active.store(false, std::memory_order_release);
+        }
+
+        HazardRecord* operator->() const noexcept {
+            return record_;
+        }
+
+        HazardRecord& operator*() const noexcept {
+            return *record_;
+        }
+
+    private:
+        HazardRecord* record_;
+    };
+
+    // A thread first tries the record matching its ThreadIndex, which is
+    // nearly always free, and only then searches.
+    HazardRecord* AcquireRecord() {
+        const std::size_t index = ::detail::ThreadIndex::Current();
+        if (index != ::detail::ThreadIndex::kNone && TryAcquire(records_[index])) {
+            return &records_[index];
+        }
+        for (HazardRecord& record : records_) {
+            if (TryAcquire(record)) {
+                return &record;
+            }
+        }
+        for (HazardRecord* record = overflow_.load(std::memory_order_acquire); record != nullptr;
+             record = record->next) {
+            if (TryAcquire(*record)) {
+                return record;
+            }
+        }
+        HazardRecord* record = new HazardRecord;
+        record->active.store(true, std::memory_order_relaxed);
+        record->next = overflow_.load(std::memory_order_relaxed);
+        while (!overflow_.compare_exchange_weak(record->next, record, std::memory_order_release,
+                                                std::memory_order_relaxed)) {
+        }
+        return record;
+    }
+
+    static bool TryAcquire(HazardRecord& record) noexcept {
+        return !record.active.load(std::memory_order_relaxed) &&
+               !record.active.exchange(true, std::memory_order_acquire);
+    }
+
+    // Publishes source's current value in hazard and returns it once source
+    // still holds it afterwards, so that it cannot have been freed between
+    // the load and the publication.
+    static Node* Protect(std::atomic<Node*>& hazard, const std::atomic<Node*>& source) noexcept {
+        Node* node = source.load();
+        while (true) {
+            hazard.store(node);
+            Node* again = source.load();
+            if (again == node) {
+                return node;
+            }
+            node = again;
+        }
+    }
+
+    void Retire(HazardRecord& record, Node* node) {
+        node->retired_next = record.retired;
+        record.retired = node;
+        if (++record.retired_count >= kRetireThreshold) {
+            Scan(record);
+        }
+    }
+
+    // Frees the retired nodes of record that no hazard pointer refers to. The
+    // hazard pointers of the fixed records are copied out once, and only the
+    // set ones, so the usual check is a short search in a local array.
+    void Scan(HazardRecord& record) {
+        const Node* hazards[std::size(records_) * kHazardsPerThread];
+        std::size_t hazard_count = 0;
+        for (const HazardRecord& other : records_) {
+            for (const std::atomic<Node*>& hazard : other.hazards) {
+                if (const Node* node = hazard.load()) {
+                    hazards[hazard_count++] = node;
+                }
+            }
+        }
+        const HazardRecord* overflow = overflow_.load(std::memory_order_acquire);
+
+        Node* keep = nullptr;
+        std::size_t kept = 0;
+        for (Node* node = record.retired; node != nullptr;) {
+            Node* next = node->retired_next;
+            if (std::find(hazards, hazards + hazard_count, node) != hazards + hazard_count ||
+                IsHazardous(overflow, node)) {
+                node->retired_next = keep;
+                keep = node;
+                ++kept;
+            } else {
+                DeallocateNode(node);
+            }
+            node = next;
+        }
+        record.retired = keep;
+        record.retired_count = kept;
+    }
+
+    static bool IsHazardous(const HazardRecord* records, const Node* node) noexcept {
+        for (; records != nullptr; records = records->next) {
+            for (const std::atomic<Node*>& hazard : records->hazards) {
+                if (hazard.load() == node) {
+                    return true;
+                }
+            }
+        }
+        return false;
+    }
+
+    void FreeRetired(HazardRecord& record) noexcept {
+        while (record.retired != nullptr) {
+            Node* next = record.retired->retired_next;
+            DeallocateNode(record.retired);
+            record.retired = next;
+        }
+        record.retired_count = 0;
+    }
+
+    Node* AllocateNode() {
+        Node* node = node_traits::allocate(alloc_, 1);
+        return ::new (static_cast<void*>(node)) Node;
+    }
+
+    void DeallocateNode(Node* node) noexcept {
+        node->~Node();
+        node_traits::deallocate(alloc_, node, 1);
+    }
+
+    alignas(::detail::kCacheLineSize) std::atomic<Node*> head_;
+    alignas(::detail::kCacheLineSize) std::atomic<Node*> tail_;
+    node_allocator alloc_;
+    HazardRecord records_[::detail::ThreadIndex::kMaxThreads];
+    std::atomic<HazardRecord*> overflow_{nullptr};
+};
+
+}  // namespace task
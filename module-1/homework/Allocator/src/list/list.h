@@ -1,81 +1,787 @@
 #pragma once
 
+#include <algorithm>
+#include <cstddef>
+#include <functional>
+#include <iterator>
 #include <list>
 #include <memory>
 #include <type_traits>
+#include <utility>
+#include <vector>
 
 namespace task {
 
+namespace detail {
+
+// Allocators whose deallocate does nothing, such as CustomAllocator in arena
+// mode, report it through IsMonotonic().
+template <typename Allocator, typename = void>
+struct HasIsMonotonic : std::false_type {};
+
+template <typename Allocator>
+struct HasIsMonotonic<Allocator,
+                      std::void_t<decltype(std::declval<const Allocator&>().IsMonotonic())>>
+    : std::true_type {};
+
+// Allocators that can hand out many single-object blocks in one request,
+// such as CustomAllocator, provide AllocateBatch(count, sink) and
+// AllocateFresh(blocks, count), the latter carving them side by side.
+template <typename Allocator, typename = void>
+struct HasAllocateBatch : std::false_type {};
+
+template <typename Allocator>
+using BatchSink = void (*)(typename Allocator::value_type*);
+
+template <typename Allocator>
+struct HasAllocateBatch<Allocator,
+                        std::void_t<decltype(std::declval<Allocator&>().AllocateBatch(
+                            1, std::declval<BatchSink<Allocator>>()))>> : std::true_type {};
+
+template <typename Allocator, typename = void>
+struct HasAllocateFresh : std::false_type {};
+
+template <typename Allocator>
+struct HasAllocateFresh<Allocator, std::void_t<decltype(std::declval<Allocator&>().AllocateFresh(
+                                       std::declval<typename Allocator::value_type**>(), 1))>>
+    : std::true_type {};
+
+}  // namespace detail
+
+// How List::Compact lays the elements out again.
+enum class CompactMode {
+    // Move-construct every element into a new node; the new nodes are carved
+    // side by side when the allocator supports it. Invalidates all iterators,
+    // pointers and references.
+    kRelocate,
+    // Keep every node where it is and allocate nothing, but move-assign the
+    // elements between nodes so that a walk visits the nodes in ascending
+    // address order. Element identity is not preserved: iterators, pointers
+    // and references stay dereferenceable, yet afterwards refer to whichever
+    // element landed in their node.
+    kReuseNodes,
+};
+
 template <typename T, typename Allocator = std::allocator<T>>
 class List {
+    // Nodes form a ring through head_, which is a sentinel and never holds a value.
+    struct NodeBase {
+        NodeBase* prev;
+        NodeBase* next;
+    };
+
+    struct Node : NodeBase {
+        T value;
+    };
+
+    template <bool IsConst>
+    class Iterator;
 
 public:
     using value_type = T;
-    // Your code goes here
+    using allocator_type = Allocator;
+    using size_type = std::size_t;
+    using difference_type = std::ptrdiff_t;
+    using reference = value_type&;
+    using const_reference = const value_type&;
+    using pointer = typename std::allocator_traits<Allocator>::pointer;
+    using const_pointer = typename std::allocator_traits<Allocator>::const_pointer;
+    using iterator = Iterator<false>;
+    using const_iterator = Iterator<true>;
 
     // Special member functions
-    List(){};
+    List() : List(Allocator()) {
+    }
+
+    explicit List(const Allocator& alloc) : alloc_(alloc) {
+        ResetHead();
+    }
+
+    List(const List& other)
+        : alloc_(node_traits::select_on_container_copy_construction(other.alloc_)) {
+        ResetHead();
+        Append(other.Begin(), other.End());
+    }
 
-    List(const List& other) {
-        // Your code goes here
+    List(const List& other, const Allocator& alloc) : List(alloc) {
+        Append(other.Begin(), other.End());
     }
-    List(const List& other, const Allocator& alloc);
 
-    List(List&& other);
-    List(List&& other, const Allocator& alloc);
+    List(List&& other) : alloc_(std::move(other.alloc_)) {
+        ResetHead();
+        SwapNodes(other);
+    }
 
-    ~List();
+    List(List&& other, const Allocator& alloc) : List(alloc) {
+        if (alloc_ == other.alloc_) {
+            SwapNodes(other);
+        } else {
+            for (T& value : other) {
+                EmplaceBack(std::move(value));
+            }
+            other.Clear();
+        }
+    }
 
-    List& operator=(const List& other);
+    ~List() {
+        Clear();
+    }
 
-    List& operator=(List&& other) noexcept;
+    List& operator=(const List& other) {
+        if (this == &other) {
+            return *this;
+        }
+        if constexpr (node_traits::propagate_on_container_copy_assignment::value) {
+            // Nodes must go back to the allocator that made them.
+            if (alloc_ != other.alloc_) {
+                Clear();
+            }
+            alloc_ = other.alloc_;
+        }
+        Assign(other.Begin(), other.End());
+        return *this;
+    }
+
+    // O(1) when the allocator propagates or the two compare equal; otherwise
+    // this list's allocator cannot free other's nodes, so the elements are
+    // moved over one by one.
+    List& operator=(List&& other) noexcept(
+        node_traits::propagate_on_container_move_assignment::value ||
+        node_traits::is_always_equal::value) {
+        if (this == &other) {
+            return *this;
+        }
+        if constexpr (node_traits::propagate_on_container_move_assignment::value) {
+            Clear();
+            alloc_ = std::move(other.alloc_);
+            SwapNodes(other);
+        } else {
+            if (alloc_ == other.alloc_) {
+                Clear();
+                SwapNodes(other);
+            } else {
+                Assign(std::make_move_iterator(other.Begin()),
+                       std::make_move_iterator(other.End()));
+                other.Clear();
+            }
+        }
+        return *this;
+    }
 
     // Element access
-    reference Front();
-    const_reference Front() const;
-    reference Back();
-    const_reference Back() const;
+    reference Front() {
+        return ValueOf(head_.next);
+    }
+
+    const_reference Front() const {
+        return ValueOf(head_.next);
+    }
+
+    reference Back() {
+        return ValueOf(head_.prev);
+    }
+
+    const_reference Back() const {
+        return ValueOf(head_.prev);
+    }
 
     // Iterators
-    iterator Begin() noexcept;
-    const_iterator Begin() const noexcept;
+    iterator Begin() noexcept {
+        return iterator(head_.next);
+    }
+
+    const_iterator Begin() const noexcept {
+        return const_iterator(head_.next);
+    }
+
+    iterator End() noexcept {
+        return iterator(&head_);
+    }
 
-    iterator End() noexcept;
-    const_iterator End() const noexcept;
+    const_iterator End() const noexcept {
+        return const_iterator(&head_);
+    }
+
+    // Lower-case aliases so that range-for and the standard algorithms work.
+    iterator begin() noexcept {  // NOLINT
+        return Begin();
+    }
+
+    const_iterator begin() const noexcept {  // NOLINT
+        return Begin();
+    }
+
+    iterator end() noexcept {  // NOLINT
+        return End();
+    }
+
+    const_iterator end() const noexcept {  // NOLINT
+        return End();
+    }
 
     // Capacity
-    bool Empty() const noexcept;
+    bool Empty() const noexcept {
+        return size_ == 0;
+    }
 
-    size_type Size() const noexcept;
-    size_type MaxSize() const noexcept;
+    size_type Size() const noexcept {
+        return size_;
+    }
+
+    size_type MaxSize() const noexcept {
+        return node_traits::max_size(alloc_);
+    }
 
     // Modifiers
-    void Clear();
-    void Swap(List& other) noexcept;
+    void Clear() {
+        if (CanAbandonNodes()) {
+            ResetHead();
+            size_ = 0;
+            return;
+        }
+        for (NodeBase* it = head_.next; it != &head_;) {
+            NodeBase* next = it->next;
+            DestroyNode(it);
+            it = next;
+        }
+        ResetHead();
+        size_ = 0;
+    }
+
+    // Without propagate_on_container_swap the allocators must compare equal.
+    void Swap(List& other) noexcept {
+        if constexpr (node_traits::propagate_on_container_swap::value) {
+            using std::swap;
+            swap(alloc_, other.alloc_);
+        }
+        SwapNodes(other);
+    }
+
+    void PushBack(const T& value) {
+        EmplaceBack(value);
+    }
 
-    void PushBack(const T& value);
-    void PushBack(T&& value);
-    
+    void PushBack(T&& value) {
+        EmplaceBack(std::move(value));
+    }
+
+    template <typename... Args>
+    void EmplaceBack(Args&&... args) {
+        LinkBefore(&head_, CreateNode(std::forward<Args>(args)...));
+    }
+
+    // Appends count elements, each constructed in place from args, which
+    // are passed as lvalues every time. All the nodes come from the allocator
+    // in one request; if a constructor throws, the list is left unchanged.
     template <typename... Args>
-    void EmplaceBack(Args&&... args);
-    void PopBack();
-    void PushFront(const T& value);
-    void PushFront(T&& value);
+    void EmplaceBackN(size_type count, const Args&... args) {
+        AppendNodes(count, [&](T* value) { node_traits::construct(alloc_, value, args...); });
+    }
+
+    // Appends copies of [first, last). With forward iterators all the nodes
+    // come from the allocator in one request and the list is left unchanged
+    // if a constructor throws.
+    template <typename InputIt>
+    void Append(InputIt first, InputIt last) {
+        using Category = typename std::iterator_traits<InputIt>::iterator_category;
+        if constexpr (std::is_base_of_v<std::forward_iterator_tag, Category>) {
+            const auto count = static_cast<size_type>(std::distance(first, last));
+            AppendNodes(count, [&](T* value) {
+                node_traits::construct(alloc_, value, *first);
+                ++first;
+            });
+        } else {
+            for (; first != last; ++first) {
+                EmplaceBack(*first);
+            }
+        }
+    }
+
+    void PopBack() {
+        Erase(head_.prev);
+    }
+
+    void PushFront(const T& value) {
+        EmplaceFront(value);
+    }
+
+    void PushFront(T&& value) {
+        EmplaceFront(std::move(value));
+    }
+
     template <typename... Args>
-    void EmplaceFront(Args&&... args);
-    void PopFront();
+    void EmplaceFront(Args&&... args) {
+        LinkBefore(head_.next, CreateNode(std::forward<Args>(args)...));
+    }
+
+    void PopFront() {
+        Erase(head_.next);
+    }
 
-    void Resize(size_type count);
+    void Resize(size_type count) {
+        while (size_ > count) {
+            PopBack();
+        }
+        if (size_ < count) {
+            EmplaceBackN(count - size_);
+        }
+    }
 
     // Operations
-    void Remove(const T& value);
-    void Unique();
-    void Sort();
+    void Remove(const T& value) {
+        // value may live in one of the nodes being removed; that node goes last.
+        NodeBase* deferred = nullptr;
+        for (NodeBase* it = head_.next; it != &head_;) {
+            NodeBase* next = it->next;
+            if (ValueOf(it) == value) {
+                if (std::addressof(ValueOf(it)) == std::addressof(value)) {
+                    deferred = it;
+                } else {
+                    Erase(it);
+                }
+            }
+            it = next;
+        }
+        if (deferred != nullptr) {
+            Erase(deferred);
+        }
+    }
+
+    void Unique() {
+        if (size_ < 2) {
+            return;
+        }
+        for (NodeBase* it = head_.next; it->next != &head_;) {
+            if (ValueOf(it->next) == ValueOf(it)) {
+                Erase(it->next);
+            } else {
+                it = it->next;
+            }
+        }
+    }
+
+    // Stable bottom-up merge sort on the links: no allocation, no element moves.
+    void Sort() {
+        if (size_ < 2) {
+            return;
+        }
+        // bins[i] holds a sorted, null-terminated run of 2^i nodes; each node
+        // is carried up like a binary counter.
+        NodeBase* bins[64] = {};
+        size_type used = 0;
+
+        head_.prev->next = nullptr;
+        for (NodeBase* it = head_.next; it != nullptr;) {
+            NodeBase* carry = it;
+            it = it->next;
+            carry->next = nullptr;
+
+            size_type i = 0;
+            for (; bins[i] != nullptr; ++i) {
+                carry = MergeRuns(bins[i], carry);
+                bins[i] = nullptr;
+            }
+            bins[i] = carry;
+            if (i >= used) {
+                used = i + 1;
+            }
+        }
+
+        NodeBase* sorted = nullptr;
+        for (size_type i = 0; i < used; ++i) {
+            sorted = MergeRuns(bins[i], sorted);
+        }
+
+        // Only the next links were maintained; restore prev and close the ring.
+        NodeBase* prev = &head_;
+        for (NodeBase* it = sorted; it != nullptr; it = it->next) {
+            it->prev = prev;
+            prev->next = it;
+            prev = it;
+        }
+        prev->next = &head_;
+        head_.prev = prev;
+    }
 
-    allocator_type GetAllocator() const noexcept;
+    // Restores locality after churn has scattered the nodes across memory,
+    // so that a forward walk becomes a near-sequential scan. Element order is
+    // unchanged.
+    void Compact(CompactMode mode = CompactMode::kRelocate) {
+        if (size_ < 2) {
+            return;
+        }
+        if (mode == CompactMode::kRelocate) {
+            Relocate();
+        } else {
+            SortNodesByAddress();
+        }
+    }
+
+    allocator_type GetAllocator() const noexcept {
+        return allocator_type(alloc_);
+    }
 
 private:
-    // Your code goes here
+    using node_allocator = typename std::allocator_traits<Allocator>::template rebind_alloc<Node>;
+    using node_traits = std::allocator_traits<node_allocator>;
+
+    template <bool IsConst>
+    class Iterator {
+    public:
+        using iterator_category = std::bidirectional_iterator_tag;
+        using value_type = T;
+        using difference_type = std::ptrdiff_t;
+        using pointer = std::conditional_t<IsConst, const T*, T*>;
+        using reference = std::conditional_t<IsConst, const T&, T&>;
+        using node_pointer = std::conditional_t<IsConst, const NodeBase*, NodeBase*>;
+
+        Iterator() = default;
+
+        // iterator converts to const_iterator, not the other way round.
+        template <bool OtherConst, typename = std::enable_if_t<IsConst && !OtherConst>>
+        Iterator(const Iterator<OtherConst>& other) : node_(other.node_) {  // NOLINT
+        }
+
+        reference operator*() const {
+            return ValueOf(node_);
+        }
+
+        pointer operator->() const {
+            return std::addressof(ValueOf(node_));
+        }
+
+        Iterator& operator++() {
+            node_ = node_->next;
+            return *this;
+        }
+
+        Iterator operator++(int) {
+            Iterator copy = *this;
+            node_ = node_->next;
+            return copy;
+        }
+
+        Iterator& operator--() {
+            node_ = node_->prev;
+            return *this;
+        }
+
+        Iterator operator--(int) {
+            Iterator copy = *this;
+            node_ = node_->prev;
+            return copy;
+        }
+
+        friend bool operator==(const Iterator& lhs, const Iterator& rhs) {
+            return lhs.node_ == rhs.node_;
+        }
+
+        friend bool operator!=(const Iterator& lhs, const Iterator& rhs) {
+            return lhs.node_ != rhs.node_;
+        }
+
+    private:
+        friend class List;
+
+        template <bool>
+        friend class Iterator;
+
+        explicit Iterator(node_pointer node) : node_(node) {
+        }
+
+        node_pointer node_ = nullptr;
+    };
+
+    static T& ValueOf(NodeBase* node) {
+        return static_cast<Node*>(node)->value;
+    }
+
+    static const T& ValueOf(const NodeBase* node) {
+        return static_cast<const Node*>(node)->value;
+    }
+
+    // Only the value is constructed; the links are plain pointers written by
+    // whoever links the node in.
+    template <typename... Args>
+    Node* CreateNode(Args&&... args) {
+        Node* node = node_traits::allocate(alloc_, 1);
+        try {
+            node_traits::construct(alloc_, std::addressof(node->value),
+                                   std::forward<Args>(args)...);
+        } catch (...) {
+            node_traits::deallocate(alloc_, node, 1);
+            throw;
+        }
+        return node;
+    }
+
+    void DestroyNode(NodeBase* base) {
+        Node* node = static_cast<Node*>(base);
+        node_traits::destroy(alloc_, std::addressof(node->value));
+        node_traits::deallocate(alloc_, node, 1);
+    }
+
+    // Replaces the nodes front to back, a batch of fresh blocks at a time.
+    // Each old node is freed as soon as its element has moved, so the list is
+    // intact whenever an element constructor throws.
+    void Relocate() {
+        constexpr size_type kBatch = 64;
+        Node* fresh[kBatch];
+        NodeBase* it = head_.next;
+        for (size_type remaining = size_; remaining > 0;) {
+            const size_type count = std::min(kBatch, remaining);
+            AllocateFreshNodes(fresh, count);
+            size_type used = 0;
+            try {
+                for (; used < count; ++used) {
+                    Node* node = fresh[used];
+                    node_traits::construct(alloc_, std::addressof(node->value),
+                                           std::move_if_noexcept(ValueOf(it)));
+                    node->prev = it->prev;
+                    node->next = it->next;
+                    it->prev->next = node;
+                    it->next->prev = node;
+                    NodeBase* next = it->next;
+                    DestroyNode(it);
+                    it = next;
+                }
+            } catch (...) {
+                DeallocateNodes(fresh + used, count - used);
+                throw;
+            }
+            remaining -= count;
+        }
+    }
+
+    void AllocateFreshNodes(Node** nodes, size_type count) {
+        if constexpr (detail::HasAllocateFresh<node_allocator>::value) {
+            alloc_.AllocateFresh(nodes, count);
+        } else {
+            size_type i = 0;
+            try {
+                for (; i < count; ++i) {
+                    nodes[i] = node_traits::allocate(alloc_, 1);
+                }
+            } catch (...) {
+                DeallocateNodes(nodes, i);
+                throw;
+            }
+        }
+    }
+
+    void DeallocateNodes(Node** nodes, size_type count) noexcept {
+        for (size_type i = 0; i < count; ++i) {
+            node_traits::deallocate(alloc_, nodes[i], 1);
+        }
+    }
+
+    // Takes count nodes, chained through next in the order the allocator gave
+    // them, then constructs the values front to back with construct(T*) and
+    // links the finished chain in at the end.
+    template <typename Construct>
+    void AppendNodes(size_type count, Construct construct) {
+        if (count == 0) {
+            return;
+        }
+        NodeBase* chain = nullptr;
+        NodeBase** tail = &chain;
+        try {
+            AllocateNodes(count, [&tail](Node* node) {
+                *tail = node;
+                tail = &node->next;
+            });
+        } catch (...) {
+            *tail = nullptr;
+            DeallocateChain(chain);
+            throw;
+        }
+        *tail = nullptr;
+
+        NodeBase built;
+        built.next = nullptr;
+        NodeBase* last = &built;
+        try {
+            while (chain != nullptr) {
+                construct(std::addressof(static_cast<Node*>(chain)->value));
+                NodeBase* node = chain;
+                chain = chain->next;
+                node->prev = last;
+                last->next = node;
+                last = node;
+            }
+        } catch (...) {
+            DeallocateChain(chain);
+            last->next = nullptr;
+            for (NodeBase* it = built.next; it != nullptr;) {
+                NodeBase* next = it->next;
+                DestroyNode(it);
+                it = next;
+            }
+            throw;
+        }
+
+        NodeBase* first = built.next;
+        first->prev = head_.prev;
+        head_.prev->next = first;
+        last->next = &head_;
+        head_.prev = last;
+        size_ += count;
+    }
+
+    template <typename Sink>
+    void AllocateNodes(size_type count, Sink&& sink) {
+        if constexpr (detail::HasAllocateBatch<node_allocator>::value) {
+            alloc_.AllocateBatch(count, sink);
+        } else {
+            for (size_type i = 0; i < count; ++i) {
+                sink(node_traits::allocate(alloc_, 1));
+            }
+        }
+    }
+
+    // Frees a null-terminated chain of nodes whose values were never built.
+    void DeallocateChain(NodeBase* chain) noexcept {
+        while (chain != nullptr) {
+            NodeBase* next = chain->next;
+            node_traits::deallocate(alloc_, static_cast<Node*>(chain), 1);
+            chain = next;
+        }
+    }
+
+    // The element at position i in iteration order must end up in the node
+    // with the i-th lowest address. The values are moved along the cycles of
+    // that permutation with one temporary per cycle, then the nodes are
+    // relinked in address order.
+    void SortNodesByAddress() {
+        std::vector<NodeBase*> order;
+        order.reserve(size_);
+        for (NodeBase* it = head_.next; it != &head_; it = it->next) {
+            order.push_back(it);
+        }
+        std::vector<NodeBase*> by_address = order;
+        std::sort(by_address.begin(), by_address.end(), std::less<NodeBase*>());
+        auto rank_of = [&by_address](NodeBase* node) {
+            return static_cast<size_type>(
+                std::lower_bound(by_address.begin(), by_address.end(), node,
+                                 std::less<NodeBase*>()) -
+                by_address.begin());
+        };
+
+        // by_address[r] receives the element now in order[r].
+        std::vector<bool> done(size_, false);
+        for (size_type start = 0; start < size_; ++start) {
+            if (done[start] || by_address[start] == order[start]) {
+                continue;
+            }
+            T carried = std::move(ValueOf(by_address[start]));
+            size_type rank = start;
+            while (true) {
+                done[rank] = true;
+                NodeBase* source = order[rank];
+                if (source == by_address[start]) {
+                    ValueOf(by_address[rank]) = std::move(carried);
+                    break;
+                }
+                ValueOf(by_address[rank]) = std::move(ValueOf(source));
+                rank = rank_of(source);
+            }
+        }
+
+        NodeBase* prev = &head_;
+        for (NodeBase* node : by_address) {
+            node->prev = prev;
+            prev->next = node;
+            prev = node;
+        }
+        prev->next = &head_;
+        head_.prev = prev;
+    }
+
+    // Nodes that need neither a destructor call nor a deallocate can be
+    // dropped without walking them; their arena frees them later.
+    bool CanAbandonNodes() const noexcept {
+        if constexpr (std::is_trivially_destructible_v<T> &&
+                      detail::HasIsMonotonic<node_allocator>::value) {
+            return alloc_.IsMonotonic();
+        } else {
+            return false;
+        }
+    }
+
+    void LinkBefore(NodeBase* pos, NodeBase* node) {
+        node->next = pos;
+        node->prev = pos->prev;
+        pos->prev->next = node;
+        pos->prev = node;
+        ++size_;
+    }
+
+    void Erase(NodeBase* node) {
+        node->prev->next = node->next;
+        node->next->prev = node->prev;
+        --size_;
+        DestroyNode(node);
+    }
+
+    // Copy-assigns over the existing elements, then trims or extends, so
+    // assigning between lists of similar size reuses their nodes.
+    template <typename InputIt>
+    void Assign(InputIt first, InputIt last) {
+        NodeBase* it = head_.next;
+        for (; it != &head_ && first != last; it = it->next, ++first) {
+            ValueOf(it) = *first;
+        }
+        while (it != &head_) {
+            NodeBase* next = it->next;
+            Erase(it);
+            it = next;
+        }
+        Append(first, last);
+    }
+
+    void ResetHead() {
+        head_.prev = &head_;
+        head_.next = &head_;
+    }
+
+    void SwapNodes(List& other) noexcept {
+        std::swap(head_, other.head_);
+        std::swap(size_, other.size_);
+        // The rings still point at the other object's sentinel.
+        FixRing();
+        other.FixRing();
+    }
+
+    void FixRing() {
+        if (size_ == 0) {
+            ResetHead();
+        } else {
+            head_.next->prev = &head_;
+            head_.prev->next = &head_;
+        }
+    }
+
+    // Merges two sorted null-terminated runs; ties take from first.
+    static NodeBase* MergeRuns(NodeBase* first, NodeBase* second) {
+        NodeBase merged;
+        NodeBase* tail = &merged;
+        while (first != nullptr && second != nullptr) {
+            if (ValueOf(second) < ValueOf(first)) {
+                tail->next = second;
+                second = second->next;
+            } else {
+                tail->next = first;
+                first = first->next;
+            }
+            tail = tail->next;
+        }
+        tail->next = (first != nullptr) ? first : second;
+        return merged.next;
+    }
+
+    NodeBase head_;
+    size_type size_ = 0;
+    node_allocator alloc_;
 };
 
-}  // namespace task
\ No newline at end of file
+}  // namespace task
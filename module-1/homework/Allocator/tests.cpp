@@ -1,12 +1,51 @@
 #include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <iterator>
 #include <list>
+#include <memory>
+#include <numeric>
+#include <optional>
 #include <random>
+#include <sstream>
+#include <stdexcept>
 #include <string>
+#include <thread>
+#include <type_traits>
+#include <vector>
 
 #include "gtest/gtest.h"
 #include "src/allocator/allocator.h"
+#include "src/list/concurrent_queue.h"
 #include "src/list/list.h"
 
+// A CustomAllocator arena that stays with its container: it is not moved by
+// move-assignment or swap, follows copy-assignment, and a copy-constructed
+// container gets an arena of its own.
+template <typename T>
+class StickyArena : public CustomAllocator<T> {
+public:
+    template <typename U>
+    struct rebind {  // NOLINT
+        using other = StickyArena<U>;
+    };
+
+    using propagate_on_container_copy_assignment = std::true_type;
+    using propagate_on_container_move_assignment = std::false_type;
+    using propagate_on_container_swap = std::false_type;
+
+    StickyArena() : CustomAllocator<T>(kMonotonicArena) {
+    }
+
+    template <typename U>
+    explicit StickyArena(const StickyArena<U>& other) : CustomAllocator<T>(other) {
+    }
+
+    StickyArena select_on_container_copy_construction() const {  // NOLINT
+        return StickyArena();
+    }
+};
+
 TEST(CopyAssignment, Test) {
     task::List<std::string, CustomAllocator<std::string>> actual;
     task::List<std::string, CustomAllocator<std::string>> actual_copy;
@@ -259,7 +298,542 @@ TEST(Mixed, Test1) {
     ASSERT_TRUE(std::equal(actual.Begin(), actual.End(), expected.begin(), expected.end()));
 }
 
+TEST(CustomAllocator, ReusesFreedBlocks) {
+    CustomAllocator<int> alloc;
+    int* first = alloc.allocate(1);
+    alloc.deallocate(first, 1);
+    int* second = alloc.allocate(1);
+    ASSERT_EQ(first, second);
+    alloc.deallocate(second, 1);
+}
+
+TEST(CustomAllocator, CopiesAndRebindsShareState) {
+    CustomAllocator<int> alloc;
+    CustomAllocator<int> copy(alloc);
+    CustomAllocator<double> rebound(alloc);
+    CustomAllocator<int> other;
+    ASSERT_TRUE(alloc == copy);
+    ASSERT_TRUE(alloc == rebound);
+    ASSERT_TRUE(alloc != other);
+
+    // Memory from one copy may be returned through another.
+    int* p = copy.allocate(1);
+    alloc.deallocate(p, 1);
+}
+
+TEST(CustomAllocator, OverAlignedBlocks) {
+    struct alignas(64) Line {
+        char bytes[64];
+    };
+    CustomAllocator<Line> alloc;
+    std::vector<Line*> lines;
+    for (std::size_t i = 0; i < 1000; ++i) {
+        lines.push_back(alloc.allocate(1));
+        ASSERT_EQ(reinterpret_cast<std::uintptr_t>(lines.back()) % 64, 0u);
+    }
+    for (Line* line : lines) {
+        alloc.deallocate(line, 1);
+    }
+}
+
+TEST(CustomAllocator, ManyChunks) {
+    task::List<int, CustomAllocator<int>> actual;
+    std::list<int> expected;
+    for (int i = 0; i < 100000; ++i) {
+        actual.PushBack(i);
+        expected.push_back(i);
+        if (i % 3 == 0) {
+            actual.PopFront();
+            expected.pop_front();
+        }
+    }
+    ASSERT_EQ(actual.Size(), expected.size());
+    ASSERT_TRUE(std::equal(actual.Begin(), actual.End(), expected.begin(), expected.end()));
+}
+
+TEST(CustomAllocator, SharedAcrossThreads) {
+    using List = task::List<int, CustomAllocator<int>>;
+    CustomAllocator<int> alloc;
+    std::vector<List> lists(8, List(alloc));
+    std::vector<std::thread> threads;
+    for (std::size_t t = 0; t < lists.size(); ++t) {
+        threads.emplace_back([&lists, t] {
+            List& list = lists[t];
+            for (int i = 0; i < 20000; ++i) {
+                list.PushBack(i);
+                if (i % 4 == 0) {
+                    list.PopFront();
+                }
+            }
+        });
+    }
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+
+    // Nodes allocated on the worker threads are freed on this one.
+    for (List& list : lists) {
+        ASSERT_EQ(list.Size(), 15000u);
+        ASSERT_EQ(list.Front(), 5000);
+        ASSERT_EQ(list.Back(), 19999);
+        list.Clear();
+    }
+}
+
+TEST(CustomAllocator, MonotonicArenaDoesNotReuse) {
+    CustomAllocator<int> alloc(kMonotonicArena);
+    CustomAllocator<int> copy(alloc);
+    ASSERT_TRUE(copy.IsMonotonic());
+    ASSERT_FALSE(CustomAllocator<int>().IsMonotonic());
+
+    int* first = alloc.allocate(1);
+    alloc.deallocate(first, 1);
+    int* second = copy.allocate(1);
+    ASSERT_NE(first, second);
+}
+
+TEST(CustomAllocator, MonotonicArenaList) {
+    CustomAllocator<int> ints(kMonotonicArena);
+    task::List<int, CustomAllocator<int>> actual(ints);
+    std::list<int> expected;
+    for (int round = 0; round < 3; ++round) {
+        for (int i = 0; i < 1000; ++i) {
+            actual.PushBack(i);
+            expected.push_back(i);
+        }
+        actual.PopFront();
+        expected.pop_front();
+        ASSERT_TRUE(std::equal(actual.Begin(), actual.End(), expected.begin(), expected.end()));
+        actual.Clear();
+        expected.clear();
+        ASSERT_TRUE(actual.Empty());
+    }
+
+    // Elements with destructors are still destroyed one by one.
+    CustomAllocator<std::string> strings(kMonotonicArena);
+    task::List<std::string, CustomAllocator<std::string>> words(strings);
+    for (int i = 0; i < 100; ++i) {
+        words.PushBack(std::string(100, 'a'));
+    }
+    words.Clear();
+    ASSERT_TRUE(words.Empty());
+}
+
+TEST(CustomAllocator, Stats) {
+    static_assert(sizeof(CustomAllocator<int>) == 2 * sizeof(void*));
+
+    CustomAllocator<int, CollectStats> alloc;
+    {
+        task::List<int, CustomAllocator<int, CollectStats>> list(alloc);
+        for (int i = 0; i < 100; ++i) {
+            list.PushBack(i);
+        }
+        list.PopBack();
+
+        AllocatorStats stats = alloc.GetStats();
+        ASSERT_EQ(stats.allocate_calls, 100u);
+        ASSERT_EQ(stats.deallocate_calls, 1u);
+        ASSERT_EQ(stats.construct_calls, 100u);
+        ASSERT_EQ(stats.destroy_calls, 1u);
+        ASSERT_EQ(stats.peak_bytes, stats.live_bytes + stats.live_bytes / 99);
+        ASSERT_GE(stats.chunks, 1u);
+
+        std::size_t live_blocks = 0;
+        for (const SizeClassStats& size_class : stats.size_classes) {
+            live_blocks += size_class.live_blocks;
+        }
+        ASSERT_EQ(live_blocks, 99u);
+    }
+
+    AllocatorStats stats = alloc.GetStats();
+    ASSERT_EQ(stats.live_bytes, 0u);
+    ASSERT_EQ(stats.deallocate_calls, 100u);
+    ASSERT_GE(stats.free_blocks, 100u);
+
+    std::ostringstream out;
+    alloc.DumpStats(out);
+    ASSERT_NE(out.str().find("peak bytes"), std::string::npos);
+}
+
+TEST(Propagation, MoveAssignStealsWhenAllocatorsMatch) {
+    StickyArena<int> arena;
+    task::List<int, StickyArena<int>> source(arena);
+    task::List<int, StickyArena<int>> target(arena);
+    for (int i = 0; i < 100; ++i) {
+        source.PushBack(i);
+    }
+    const int* front = &source.Front();
+
+    target = std::move(source);
+    ASSERT_EQ(&target.Front(), front);
+    ASSERT_EQ(target.Size(), 100u);
+    ASSERT_TRUE(source.Empty());
+}
+
+TEST(Propagation, MoveAssignMovesElementsOtherwise) {
+    task::List<std::string, StickyArena<std::string>> source;
+    task::List<std::string, StickyArena<std::string>> target;
+    for (int i = 0; i < 100; ++i) {
+        source.PushBack(std::to_string(i));
+    }
+    target.PushBack("stale");
+    const std::string* front = &source.Front();
+
+    target = std::move(source);
+    ASSERT_NE(&target.Front(), front);
+    ASSERT_TRUE(target.GetAllocator() != source.GetAllocator());
+    ASSERT_EQ(target.Size(), 100u);
+    ASSERT_EQ(target.Front(), "0");
+    ASSERT_EQ(target.Back(), "99");
+    ASSERT_TRUE(source.Empty());
+}
+
+TEST(Propagation, CopyFollowsTraits) {
+    task::List<int, StickyArena<int>> source;
+    source.PushBack(1);
+
+    // select_on_container_copy_construction hands the copy a fresh arena.
+    task::List<int, StickyArena<int>> copy(source);
+    ASSERT_TRUE(copy.GetAllocator() != source.GetAllocator());
+
+    // propagate_on_container_copy_assignment carries the source's arena over.
+    task::List<int, StickyArena<int>> assigned;
+    assigned.PushBack(2);
+    assigned = source;
+    ASSERT_TRUE(assigned.GetAllocator() == source.GetAllocator());
+    ASSERT_EQ(assigned.Front(), 1);
+}
+
+TEST(Propagation, PropagatingAllocatorMovesWithList) {
+    task::List<int, CustomAllocator<int>> source;
+    task::List<int, CustomAllocator<int>> target;
+    source.PushBack(1);
+    const int* front = &source.Front();
+    const CustomAllocator<int> alloc = source.GetAllocator();
+
+    target = std::move(source);
+    ASSERT_EQ(&target.Front(), front);
+    ASSERT_TRUE(target.GetAllocator() == alloc);
+
+    task::List<int, CustomAllocator<int>> other;
+    other.Swap(target);
+    ASSERT_TRUE(other.GetAllocator() == alloc);
+    ASSERT_EQ(&other.Front(), front);
+}
+
+TEST(CustomAllocator, SizeClasses) {
+    for (std::size_t bytes = 1; bytes <= detail::kMaxSizeClassBytes; ++bytes) {
+        const std::size_t index = detail::SizeClassIndex(bytes);
+        ASSERT_LT(index, detail::kSizeClassCount);
+        ASSERT_GE(detail::SizeClassBytes(index), bytes);
+        if (index > 0) {
+            ASSERT_LT(detail::SizeClassBytes(index - 1), bytes);
+        }
+    }
+}
+
+TEST(CustomAllocator, ArrayRequests) {
+    using String = std::basic_string<char, std::char_traits<char>, CustomAllocator<char>>;
+    CustomAllocator<char> alloc;
+    std::vector<String, CustomAllocator<String>> strings{CustomAllocator<String>(alloc)};
+    for (int i = 0; i < 1000; ++i) {
+        strings.emplace_back(static_cast<std::size_t>(i % 300), 'a' + i % 26, alloc);
+    }
+    for (int i = 0; i < 1000; ++i) {
+        ASSERT_EQ(strings[i].size(), static_cast<std::size_t>(i % 300));
+        ASSERT_EQ(strings[i].find_first_not_of(static_cast<char>('a' + i % 26)), String::npos);
+    }
+
+    CustomAllocator<int> ints;
+    int* small = ints.allocate(3);
+    int* large = ints.allocate(10000);
+    ints.deallocate(small, 3);
+    ASSERT_EQ(ints.allocate(4), small);
+    ints.deallocate(small, 4);
+    ints.deallocate(large, 10000);
+}
+
+TEST(CustomAllocator, FragmentationReport) {
+    CustomAllocator<char, CollectStats> alloc;
+    char* rounded = alloc.allocate(100);
+    char* exact = alloc.allocate(112);
+    char* large = alloc.allocate(10000);
+
+    AllocatorStats stats = alloc.GetStats();
+    ASSERT_EQ(stats.array_allocations, 3u);
+    ASSERT_EQ(stats.large_live_bytes, 10000u);
+    FragmentationStats fragmentation = Fragmentation(stats);
+    ASSERT_EQ(fragmentation.requested_bytes, 212u);
+    ASSERT_EQ(fragmentation.live_block_bytes, 224u);
+
+    alloc.deallocate(rounded, 100);
+    alloc.deallocate(exact, 112);
+    alloc.deallocate(large, 10000);
+    fragmentation = Fragmentation(alloc.GetStats());
+    ASSERT_EQ(fragmentation.live_block_bytes, 0u);
+    ASSERT_GT(fragmentation.external, 0.0);
+}
+
+TEST(CustomAllocator, ArenaOptions) {
+    ArenaOptions padded;
+    padded.pad_to_cache_line = true;
+    CustomAllocator<int> alloc(padded);
+    std::vector<int*> blocks;
+    for (int i = 0; i < 1000; ++i) {
+        blocks.push_back(alloc.allocate(1));
+        ASSERT_EQ(reinterpret_cast<std::uintptr_t>(blocks.back()) % 64, 0u);
+    }
+    std::sort(blocks.begin(), blocks.end());
+    for (std::size_t i = 1; i < blocks.size(); ++i) {
+        ASSERT_GE(reinterpret_cast<char*>(blocks[i]) - reinterpret_cast<char*>(blocks[i - 1]), 64);
+    }
+    for (int* block : blocks) {
+        alloc.deallocate(block, 1);
+    }
+
+    ArenaOptions all;
+    all.cache_line_chunks = true;
+    all.pad_to_cache_line = true;
+    all.huge_pages = true;
+    task::List<int, CustomAllocator<int>> actual{CustomAllocator<int>(all)};
+    std::list<int> expected;
+    for (int i = 0; i < 200000; ++i) {
+        actual.PushBack(i);
+        expected.push_back(i);
+    }
+    actual.Sort();
+    ASSERT_TRUE(std::equal(actual.Begin(), actual.End(), expected.begin(), expected.end()));
+}
+
+// Churns a list so that its nodes end up scattered across the arena.
+template <typename List>
+void Scatter(List& actual, std::list<int>& expected) {
+    std::mt19937 gen(3);
+    for (int i = 0; i < 20000; ++i) {
+        actual.PushBack(i);
+        expected.push_back(i);
+        if (gen() % 3 == 0) {
+            actual.PopFront();
+            expected.pop_front();
+        }
+    }
+    actual.Sort();
+    expected.sort();
+}
+
+// Steps of a walk that go to a lower address.
+template <typename It>
+std::size_t BackwardSteps(It first, It last) {
+    std::size_t steps = 0;
+    for (It prev = first++; first != last; prev = first++) {
+        if (std::less<const int*>()(&*first, &*prev)) {
+            ++steps;
+        }
+    }
+    return steps;
+}
+
+TEST(Compact, Relocate) {
+    task::List<int, CustomAllocator<int>> actual;
+    std::list<int> expected;
+    Scatter(actual, expected);
+    for (int i = 0; i < 1000; ++i) {
+        actual.PushFront(-i);
+        expected.push_front(-i);
+        actual.Remove(i * 7);
+        expected.remove(i * 7);
+    }
+    ASSERT_GT(BackwardSteps(actual.Begin(), actual.End()), 1000u);
+
+    actual.Compact();
+    ASSERT_TRUE(std::equal(actual.Begin(), actual.End(), expected.begin(), expected.end()));
+    // Fresh nodes are adjacent within a chunk; chunks themselves may lie in
+    // any order.
+    ASSERT_LT(BackwardSteps(actual.Begin(), actual.End()), 20u);
+}
+
+TEST(Compact, RelocateMoveOnly) {
+    task::List<std::unique_ptr<int>> actual;
+    for (int i = 0; i < 300; ++i) {
+        actual.PushBack(std::make_unique<int>(i));
+    }
+    actual.Compact(task::CompactMode::kRelocate);
+    int i = 0;
+    for (const std::unique_ptr<int>& value : actual) {
+        ASSERT_EQ(*value, i++);
+    }
+    ASSERT_EQ(i, 300);
+}
+
+TEST(Compact, ReuseNodes) {
+    task::List<int, CustomAllocator<int>> actual;
+    std::list<int> expected;
+    Scatter(actual, expected);
+    std::vector<const int*> slots;
+    for (const int& value : actual) {
+        slots.push_back(&value);
+    }
+
+    actual.Compact(task::CompactMode::kReuseNodes);
+    ASSERT_TRUE(std::equal(actual.Begin(), actual.End(), expected.begin(), expected.end()));
+    ASSERT_EQ(BackwardSteps(actual.Begin(), actual.End()), 0u);
+    // The nodes stay put but their values move: the k-th lowest address now
+    // holds the k-th element.
+    std::sort(slots.begin(), slots.end(), std::less<const int*>());
+    std::vector<const int*> after;
+    for (const int& value : actual) {
+        after.push_back(&value);
+    }
+    ASSERT_EQ(after, slots);
+    ASSERT_TRUE(std::equal(expected.begin(), expected.end(), slots.begin(), slots.end(),
+                           [](int value, const int* slot) { return *slot == value; }));
+
+    task::List<std::string> words;
+    std::list<std::string> expected_words;
+    for (int i = 0; i < 500; ++i) {
+        std::string word = std::to_string((i * 7919) % 500) + std::string(30, 'x');
+        words.PushBack(word);
+        expected_words.push_back(word);
+    }
+    words.Sort();
+    expected_words.sort();
+    words.Compact(task::CompactMode::kReuseNodes);
+    ASSERT_TRUE(
+        std::equal(words.Begin(), words.End(), expected_words.begin(), expected_words.end()));
+}
+
+// Throws from its copy constructor once the countdown reaches zero.
+struct ThrowingCopy {
+    static inline int countdown = -1;
+
+    explicit ThrowingCopy(int value) : value(value) {
+    }
+
+    ThrowingCopy(const ThrowingCopy& other) : value(other.value) {
+        if (countdown >= 0 && countdown-- == 0) {
+            throw std::runtime_error("copy");
+        }
+    }
+
+    int value;
+};
+
+TEST(BulkAppend, EmplaceBackN) {
+    task::List<std::string, CustomAllocator<std::string, CollectStats>> actual;
+    actual.PushBack("head");
+    const std::size_t calls = actual.GetAllocator().GetStats().allocate_calls;
+
+    actual.EmplaceBackN(1000, 3, 'x');
+    ASSERT_EQ(actual.Size(), 1001u);
+    ASSERT_EQ(actual.Front(), "head");
+    ASSERT_TRUE(std::all_of(std::next(actual.Begin()), actual.End(),
+                            [](const std::string& value) { return value == "xxx"; }));
+    ASSERT_EQ(actual.GetAllocator().GetStats().allocate_calls - calls, 1000u);
+
+    actual.EmplaceBackN(0);
+    ASSERT_EQ(actual.Size(), 1001u);
+}
+
+TEST(BulkAppend, Append) {
+    std::vector<int> values(5000);
+    std::iota(values.begin(), values.end(), 0);
+    task::List<int, CustomAllocator<int>> actual;
+    std::list<int> expected;
+    actual.PushBack(-1);
+    expected.push_back(-1);
+
+    actual.Append(values.begin(), values.end());
+    expected.insert(expected.end(), values.begin(), values.end());
+    ASSERT_TRUE(std::equal(actual.Begin(), actual.End(), expected.begin(), expected.end()));
+    ASSERT_TRUE(std::equal(std::make_reverse_iterator(actual.End()),
+                           std::make_reverse_iterator(actual.Begin()), expected.rbegin(),
+                           expected.rend()));
+
+    std::istringstream input("7 8 9");
+    actual.Append(std::istream_iterator<int>(input), std::istream_iterator<int>());
+    ASSERT_EQ(actual.Size(), 5004u);
+    ASSERT_EQ(actual.Back(), 9);
+}
+
+TEST(BulkAppend, ThrowingConstructorLeavesListUnchanged) {
+    std::vector<ThrowingCopy> values;
+    for (int i = 0; i < 100; ++i) {
+        values.emplace_back(i);
+    }
+    task::List<ThrowingCopy, CustomAllocator<ThrowingCopy, CollectStats>> actual;
+    actual.EmplaceBack(-1);
+    const std::size_t live_bytes = actual.GetAllocator().GetStats().live_bytes;
+
+    ThrowingCopy::countdown = 50;
+    ASSERT_THROW(actual.Append(values.begin(), values.end()), std::runtime_error);
+    ThrowingCopy::countdown = -1;
+    ASSERT_EQ(actual.Size(), 1u);
+    ASSERT_EQ(actual.Front().value, -1);
+    ASSERT_EQ(actual.GetAllocator().GetStats().live_bytes, live_bytes);
+}
+
+TEST(ConcurrentQueue, Fifo) {
+    task::ConcurrentQueue<std::unique_ptr<int>> queue;
+    ASSERT_FALSE(queue.PopFront().has_value());
+    for (int i = 0; i < 1000; ++i) {
+        queue.PushBack(std::make_unique<int>(i));
+        if (i % 3 == 2) {
+            ASSERT_EQ(**queue.PopFront(), i / 3);
+        }
+    }
+    for (int i = 1000 / 3; i < 1000; ++i) {
+        ASSERT_EQ(**queue.PopFront(), i);
+    }
+    ASSERT_FALSE(queue.PopFront().has_value());
+    // Whatever is still queued is destroyed with the queue.
+    queue.EmplaceBack(new int(-1));
+}
+
+TEST(ConcurrentQueue, ProducersAndConsumers) {
+    constexpr int kProducers = 4;
+    constexpr int kConsumers = 4;
+    constexpr int kPerProducer = 50000;
+    task::ConcurrentQueue<std::pair<int, int>> queue;
+    std::atomic<int> popped{0};
+    std::vector<std::vector<std::pair<int, int>>> seen(kConsumers);
+
+    std::vector<std::thread> threads;
+    for (int producer = 0; producer < kProducers; ++producer) {
+        threads.emplace_back([&queue, producer] {
+            for (int i = 0; i < kPerProducer; ++i) {
+                queue.PushBack({producer, i});
+            }
+        });
+    }
+    for (int consumer = 0; consumer < kConsumers; ++consumer) {
+        threads.emplace_back([&, consumer] {
+            while (popped.load() < kProducers * kPerProducer) {
+                if (std::optional<std::pair<int, int>> value = queue.PopFront()) {
+                    seen[consumer].push_back(*value);
+                    ++popped;
+                }
+            }
+        });
+    }
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+
+    std::vector<int> count(kProducers * kPerProducer);
+    for (const std::vector<std::pair<int, int>>& values : seen) {
+        // Each consumer sees every producer's elements in the order pushed.
+        std::vector<int> last(kProducers, -1);
+        for (const auto& [producer, i] : values) {
+            ASSERT_GT(i, last[producer]);
+            last[producer] = i;
+            ++count[producer * kPerProducer + i];
+        }
+    }
+    ASSERT_TRUE(std::all_of(count.begin(), count.end(), [](int n) { return n == 1; }));
+    ASSERT_FALSE(queue.PopFront().has_value());
+}
+
 int main(int argc, char** argv) {
     ::testing::InitGoogleTest(&argc, argv);
     return RUN_ALL_TESTS();
-}
\ No newline at end of file
+}
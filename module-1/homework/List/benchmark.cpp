@@ -0,0 +1,366 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <list>
+#include <new>
+#include <random>
+#include <vector>
+
+#include "list.h"
+#include "unrolled_list.h"
+
+
+namespace {
+
+size_t heap_allocations = 0;
+
+}  // namespace
+
+
+// Every heap request in the program is counted, which is how the bulk
+// sections below report node allocations.
+void* operator new(size_t size) {
+    ++heap_allocations;
+    if (void* p = std::malloc(size)) {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept {
+    std::free(p);
+}
+
+void operator delete(void* p, size_t) noexcept {
+    std::free(p);
+}
+
+
+namespace {
+
+
+// The per-element allocation scheme that list used before nodes were pooled:
+// one new/delete per push/pop.
+class heap_list {
+
+public:
+
+    heap_list() {
+        head_.prev = &head_;
+        head_.next = &head_;
+    }
+
+    ~heap_list() {
+        clear();
+    }
+
+    bool empty() const {
+        return size_ == 0;
+    }
+
+    void clear() {
+        while (!empty()) {
+            pop_back();
+        }
+    }
+
+    void push_back(const int& value) {
+        link_before(&head_, create_node(value));
+    }
+
+    void push_front(const int& value) {
+        link_before(head_.next, create_node(value));
+    }
+
+    void pop_back() {
+        erase(head_.prev);
+    }
+
+    void pop_front() {
+        erase(head_.next);
+    }
+
+private:
+
+    struct node_base {
+        node_base* prev;
+        node_base* next;
+    };
+
+    struct node : node_base {
+        int value;
+    };
+
+    static node* create_node(const int& value) {
+        node* n = new node;
+        n->value = value;
+        return n;
+    }
+
+    void link_before(node_base* pos, node_base* n) {
+        n->next = pos;
+        n->prev = pos->prev;
+        pos->prev->next = n;
+        pos->prev = n;
+        ++size_;
+    }
+
+    void erase(node_base* n) {
+        n->prev->next = n->next;
+        n->next->prev = n->prev;
+        --size_;
+        delete static_cast<node*>(n);
+    }
+
+    node_base head_;
+    size_t size_ = 0;
+
+};
+
+
+template <class F>
+double measure_ms(F&& body) {
+    auto start = std::chrono::steady_clock::now();
+    body();
+    auto finish = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::milli>(finish - start).count();
+}
+
+
+// Queue-like ingestion: a burst of pushes, then pops interleaved with pushes.
+template <class List>
+double churn(const std::vector<int>& values, size_t rounds) {
+    return measure_ms([&] {
+        List list;
+        for (size_t round = 0; round < rounds; ++round) {
+            for (int value : values) {
+                list.push_back(value);
+            }
+            for (size_t i = 0; i < values.size(); ++i) {
+                list.pop_front();
+                list.push_front(values[i]);
+                list.pop_back();
+            }
+            list.clear();
+        }
+    });
+}
+
+
+template <class List>
+void report(const char* name, const std::vector<int>& values, size_t rounds) {
+    std::printf("%-16s %10.2f ms\n", name, churn<List>(values, rounds));
+}
+
+
+template <class List>
+List make_list(const std::vector<int>& values) {
+    List list;
+    for (int value : values) {
+        list.push_back(value);
+    }
+    return list;
+}
+
+long long sum(const task::unrolled_list& list) {
+    long long total = 0;
+    list.for_each([&total](int value) { total += value; });
+    return total;
+}
+
+long long sum(const std::list<int>& list) {
+    long long total = 0;
+    for (int value : list) {
+        total += value;
+    }
+    return total;
+}
+
+// Runs remove, unique and sort on copies of the same few-distinct-values input.
+template <class List>
+void report_bulk(const char* name, const std::vector<int>& values) {
+    List removed = make_list<List>(values);
+    List uniqued = make_list<List>(values);
+    List sorted = make_list<List>(values);
+
+    double remove_ms = measure_ms([&] { removed.remove(values.front()); });
+    double unique_ms = measure_ms([&] { uniqued.unique(); });
+    double sort_ms = measure_ms([&] { sorted.sort(); });
+    std::printf("%-16s %10.2f %10.2f %10.2f\n", name, remove_ms, unique_ms, sort_ms);
+}
+
+template <class List, class Sort>
+double sort_ms(const std::vector<int>& values, Sort sort) {
+    List list = make_list<List>(values);
+    return measure_ms([&] { sort(list); });
+}
+
+void report_sort(const char* shape, const std::vector<int>& values) {
+    double merge = sort_ms<task::list>(values, [](task::list& list) { list.sort(); });
+    double radix = sort_ms<task::list>(values, [](task::list& list) { list.radix_sort(); });
+    double std_sort = sort_ms<std::list<int>>(values, [](std::list<int>& list) { list.sort(); });
+    std::printf("%-16s %10.2f %10.2f %10.2f\n", shape, merge, radix, std_sort);
+}
+
+// Prints wall time and heap allocations of body.
+template <class F>
+void report_allocations(const char* name, F&& body, bool quiet = false) {
+    const size_t before = heap_allocations;
+    double ms = measure_ms(body);
+    if (quiet) {
+        return;
+    }
+    std::printf("%-34s %10.2f ms %10zu allocs\n", name, ms, heap_allocations - before);
+}
+
+// The first round pays for faulting fresh heap pages in and is not reported.
+template <class List, class Grow>
+void report_grow(const char* name, Grow grow) {
+    for (int round = 0; round < 2; ++round) {
+        List list;
+        report_allocations(name, [&] { grow(list); }, round == 0);
+    }
+}
+
+template <class List>
+void report_walk(const char* name, const std::vector<int>& values, size_t rounds) {
+    const List list = make_list<List>(values);
+    long long total = 0;
+    double ms = measure_ms([&] {
+        for (size_t round = 0; round < rounds; ++round) {
+            total += sum(list);
+        }
+    });
+    std::printf("%-16s %10.2f ms (checksum %lld)\n", name, ms, total);
+}
+
+// Cuts the list into shards and concatenates them back, as a work-queue
+// rebalance would.
+void report_shard(size_t count, size_t shards) {
+    task::list list(count);
+    report_allocations("split + splice", [&] {
+        std::vector<task::list> parts;
+        for (size_t i = 1; i < shards; ++i) {
+            parts.push_back(list.split(list.size() - count / shards));
+        }
+        for (task::list& part : parts) {
+            list.splice(list.begin(), part);
+        }
+    });
+
+    task::list source(count);
+    report_allocations("element-wise rebuild", [&] {
+        std::vector<task::list> parts(shards);
+        size_t i = 0;
+        while (!source.empty()) {
+            parts[i++ % shards].push_back(source.front());
+            source.pop_front();
+        }
+        for (task::list& part : parts) {
+            while (!part.empty()) {
+                source.push_back(part.front());
+                part.pop_front();
+            }
+        }
+    });
+}
+
+}  // namespace
+
+
+int main() {
+    const size_t count = 1000000;
+    const size_t rounds = 10;
+
+    std::mt19937 rand(42);
+    std::vector<int> values(count);
+    for (int& value : values) {
+        value = static_cast<int>(rand());
+    }
+
+    std::printf("push/pop churn, %zu elements x %zu rounds\n", count, rounds);
+    report<task::list>("task::list", values, rounds);
+    report<heap_list>("per-node new", values, rounds);
+    report<std::list<int>>("std::list<int>", values, rounds);
+    report<task::unrolled_list>("unrolled_list", values, rounds);
+
+    // Few distinct values so that remove and unique have work to do.
+    std::vector<int> runs(count);
+    for (int& value : runs) {
+        value = static_cast<int>(rand() % 8);
+    }
+
+    std::printf("\nbulk operations, %zu elements    remove     unique       sort (ms)\n", count);
+    report_bulk<task::list>("task::list", runs);
+    report_bulk<task::unrolled_list>("unrolled_list", runs);
+    report_bulk<std::list<int>>("std::list<int>", runs);
+
+    const size_t sort_count = 2 * count;
+    std::vector<int> random(sort_count);
+    for (int& value : random) {
+        value = static_cast<int>(rand());
+    }
+    std::vector<int> ascending = random;
+    std::sort(ascending.begin(), ascending.end());
+    std::vector<int> descending(ascending.rbegin(), ascending.rend());
+    std::vector<int> few_unique(sort_count);
+    for (int& value : few_unique) {
+        value = static_cast<int>(rand() % 16);
+    }
+
+    std::printf("\nsort, %zu elements        list::sort radix_sort  std::list (ms)\n", sort_count);
+    report_sort("random", random);
+    report_sort("sorted", ascending);
+    report_sort("reversed", descending);
+    report_sort("few unique", few_unique);
+
+    std::vector<int> doomed;
+    for (int value = 0; value < 16; ++value) {
+        doomed.push_back(value * 3);
+    }
+
+    std::printf("\nbatch erase, %zu elements in [0, 8)\n", count);
+    {
+        task::list list = make_list<task::list>(runs);
+        report_allocations("list::remove x16 values", [&] {
+            for (int value : doomed) {
+                list.remove(value);
+            }
+        });
+    }
+    {
+        task::list list = make_list<task::list>(runs);
+        report_allocations("list::remove(sorted 16 values)", [&] { list.remove(doomed); });
+    }
+    {
+        task::list list = make_list<task::list>(runs);
+        report_allocations("list::remove_if(odd)", [&] {
+            list.remove_if([](int value) { return value % 2 != 0; });
+        });
+    }
+    {
+        std::list<int> list = make_list<std::list<int>>(runs);
+        report_allocations("std::list::remove_if(odd)", [&] {
+            list.remove_if([](int value) { return value % 2 != 0; });
+        });
+    }
+
+    std::printf("\ngrow from empty to %zu elements\n", count);
+    report_grow<task::list>("list::resize", [count](task::list& list) { list.resize(count); });
+    report_grow<task::list>("list::push_back loop", [count](task::list& list) {
+        for (size_t i = 0; i < count; ++i) {
+            list.push_back(0);
+        }
+    });
+    report_grow<std::list<int>>("std::list::resize",
+                                [count](std::list<int>& list) { list.resize(count); });
+
+    const size_t shards = 16;
+    std::printf("\nshard into %zu and rejoin, %zu elements\n", shards, count);
+    report_shard(count, shards);
+
+    std::printf("\nfull traversal, %zu elements x %zu rounds\n", count, rounds);
+    report_walk<task::unrolled_list>("unrolled_list", runs, rounds);
+    report_walk<std::list<int>>("std::list<int>", runs, rounds);
+}
@@ -1,3 +1,596 @@
 #include "list.h"
 
-// Your code goes here...
\ No newline at end of file
+#include <new>
+#include <utility>
+
+
+namespace task {
+
+
+list::list() : size_(0) {
+    reset_head();
+}
+
+list::list(size_t count, const int& value) : list() {
+    append_filled(count, value);
+}
+
+list::list(const list& other) : list() {
+    for (const node_base* it = other.head_.next; it != &other.head_; it = it->next) {
+        push_back(static_cast<const node*>(it)->value);
+    }
+}
+
+list::list(list&& other) noexcept : list() {
+    swap(other);
+}
+
+list::~list() {
+    clear();
+}
+
+list& list::operator=(const list& other) {
+    if (this != &other) {
+        list copy(other);
+        swap(copy);
+    }
+    return *this;
+}
+
+list& list::operator=(list&& other) noexcept {
+    if (this != &other) {
+        clear();
+        swap(other);
+    }
+    return *this;
+}
+
+
+int& list::front() {
+    return static_cast<node*>(head_.next)->value;
+}
+
+const int& list::front() const {
+    return static_cast<const node*>(head_.next)->value;
+}
+
+int& list::back() {
+    return static_cast<node*>(head_.prev)->value;
+}
+
+const int& list::back() const {
+    return static_cast<const node*>(head_.prev)->value;
+}
+
+
+list::iterator list::begin() {
+    return iterator(head_.next);
+}
+
+list::const_iterator list::begin() const {
+    return const_iterator(head_.next);
+}
+
+list::iterator list::end() {
+    return iterator(&head_);
+}
+
+list::const_iterator list::end() const {
+    return const_iterator(const_cast<node_base*>(&head_));
+}
+
+
+bool list::empty() const {
+    return size_ == 0;
+}
+
+size_t list::size() const {
+    return size_;
+}
+
+void list::clear() {
+    if (pool_.exclusive()) {
+        // Nodes hold a plain int, so there is nothing to destroy one by one:
+        // hand every block back to the pool in a single step.
+        pool_.reset();
+    } else {
+        // Other lists still hold nodes from the same blocks.
+        for (node_base* it = head_.next; it != &head_;) {
+            node_base* next = it->next;
+            destroy_node(it);
+            it = next;
+        }
+    }
+    reset_head();
+    size_ = 0;
+}
+
+
+void list::push_back(const int& value) {
+    link_before(&head_, create_node(value));
+}
+
+void list::pop_back() {
+    erase(head_.prev);
+}
+
+void list::push_front(const int& value) {
+    link_before(head_.next, create_node(value));
+}
+
+void list::pop_front() {
+    erase(head_.next);
+}
+
+void list::resize(size_t count) {
+    while (size_ > count) {
+        pop_back();
+    }
+    if (size_ < count) {
+        append_filled(count - size_, int());
+    }
+}
+
+void list::swap(list& other) {
+    std::swap(head_, other.head_);
+    std::swap(size_, other.size_);
+    pool_.swap(other.pool_);
+
+    // The rings still point at the other object's sentinel.
+    if (size_ == 0) {
+        reset_head();
+    } else {
+        head_.next->prev = &head_;
+        head_.prev->next = &head_;
+    }
+    if (other.size_ == 0) {
+        other.reset_head();
+    } else {
+        other.head_.next->prev = &other.head_;
+        other.head_.prev->next = &other.head_;
+    }
+}
+
+
+void list::remove(const int& value) {
+    // Copy first: value may refer to an element that is about to be erased.
+    const int target = value;
+    remove_if([target](int current) { return current == target; });
+}
+
+void list::remove(const std::vector<int>& sorted_values) {
+    if (sorted_values.empty()) {
+        return;
+    }
+    const int* values = sorted_values.data();
+    const size_t count = sorted_values.size();
+    const int lowest = values[0];
+    const int highest = values[count - 1];
+
+    remove_if([values, count, lowest, highest](int current) {
+        if (current < lowest || highest < current) {
+            return false;
+        }
+        // Branchless lower_bound: the loop trip count depends only on count,
+        // and the conditional move compiles to cmov rather than a jump.
+        const int* base = values;
+        size_t length = count;
+        while (length > 1) {
+            const size_t half = length / 2;
+            base = (base[half - 1] < current) ? base + half : base;
+            length -= half;
+        }
+        return *base == current;
+    });
+}
+
+void list::unique() {
+    if (size_ < 2) {
+        return;
+    }
+    int previous = 0;
+    bool first = true;
+    remove_if([&previous, &first](int current) {
+        const bool duplicate = !first && current == previous;
+        first = false;
+        previous = current;
+        return duplicate;
+    });
+}
+
+void list::sort() {
+    if (size_ < 2 || is_sorted() || reverse_if_descending()) {
+        return;
+    }
+
+    // Bottom-up merge sort on the next links. bins[i] holds a sorted run of
+    // 2^i nodes; each new node is carried up like a binary counter, so merges
+    // happen while both runs are still warm in cache. No allocation, no
+    // recursion, and 64 bins cover any size_t element count.
+    node_base* bins[64] = {};
+    size_t used = 0;
+
+    head_.prev->next = nullptr;
+    node_base* it = head_.next;
+    while (it != nullptr) {
+        node_base* carry = it;
+        it = it->next;
+        carry->next = nullptr;
+
+        size_t i = 0;
+        for (; bins[i] != nullptr; ++i) {
+            // bins[i] holds the older elements, so it goes first for stability.
+            carry = merge_sorted(bins[i], carry);
+            bins[i] = nullptr;
+        }
+        bins[i] = carry;
+        if (i >= used) {
+            used = i + 1;
+        }
+    }
+
+    // The last merge touches every node once more, so it also restores the
+    // prev links; a separate fix-up walk in sorted order would miss cache on
+    // nearly every node.
+    node_base* rest = nullptr;
+    for (size_t i = 0; i + 1 < used; ++i) {
+        if (bins[i] != nullptr) {
+            rest = merge_sorted(bins[i], rest);
+        }
+    }
+    if (rest == nullptr) {
+        relink_chain(bins[used - 1]);
+    } else {
+        merge_into_ring(bins[used - 1], rest);
+    }
+}
+
+void list::radix_sort() {
+    if (size_ < 2) {
+        return;
+    }
+
+    const size_t radix = 256;
+    const size_t passes = sizeof(int);
+
+    // Flipping the sign bit orders negative ints before positive ones.
+    auto key = [](const node_base* n) {
+        return static_cast<unsigned>(static_cast<const node*>(n)->value) ^ 0x80000000u;
+    };
+
+    // One counting pass finds the digits that actually vary.
+    size_t counts[passes][radix] = {};
+    for (const node_base* it = head_.next; it != &head_; it = it->next) {
+        const unsigned k = key(it);
+        for (size_t pass = 0; pass < passes; ++pass) {
+            ++counts[pass][(k >> (8 * pass)) & 0xff];
+        }
+    }
+
+    // Every pass rebuilds both link directions as it distributes, so the list
+    // is a valid ring again after the last pass without another walk.
+    node_base* bucket_head[radix];
+    node_base* bucket_tail[radix];
+    for (size_t pass = 0; pass < passes; ++pass) {
+        const unsigned shift = static_cast<unsigned>(8 * pass);
+        if (counts[pass][(key(head_.next) >> shift) & 0xff] == size_) {
+            continue;
+        }
+
+        for (size_t b = 0; b < radix; ++b) {
+            bucket_head[b] = nullptr;
+            bucket_tail[b] = nullptr;
+        }
+        for (node_base* it = head_.next; it != &head_;) {
+            node_base* next = it->next;
+            const size_t b = (key(it) >> shift) & 0xff;
+            if (bucket_tail[b] == nullptr) {
+                bucket_head[b] = it;
+            } else {
+                bucket_tail[b]->next = it;
+            }
+            it->prev = bucket_tail[b];
+            bucket_tail[b] = it;
+            it = next;
+        }
+
+        // Concatenate the buckets in order.
+        node_base* tail = &head_;
+        for (size_t b = 0; b < radix; ++b) {
+            if (bucket_head[b] != nullptr) {
+                tail->next = bucket_head[b];
+                bucket_head[b]->prev = tail;
+                tail = bucket_tail[b];
+            }
+        }
+        tail->next = &head_;
+        head_.prev = tail;
+    }
+}
+
+
+void list::splice(const_iterator pos, list& other) {
+    if (other.empty()) {
+        return;
+    }
+    adopt_nodes_of(other);
+    const size_t count = other.size_;
+    transfer(pos.node_, other.head_.next, &other.head_);
+    size_ += count;
+    other.size_ = 0;
+}
+
+void list::splice(const_iterator pos, list& other, const_iterator it) {
+    const_iterator last = it;
+    splice(pos, other, it, ++last, 1);
+}
+
+void list::splice(const_iterator pos, list& other, const_iterator first, const_iterator last) {
+    if (&other == this) {
+        transfer(pos.node_, first.node_, last.node_);
+        return;
+    }
+    size_t count = 0;
+    for (const_iterator it = first; it != last; ++it) {
+        ++count;
+    }
+    splice(pos, other, first, last, count);
+}
+
+void list::splice(const_iterator pos, list& other, const_iterator first, const_iterator last,
+                  size_t count) {
+    if (first == last) {
+        return;
+    }
+    if (&other != this) {
+        adopt_nodes_of(other);
+        size_ += count;
+        other.size_ -= count;
+    }
+    transfer(pos.node_, first.node_, last.node_);
+}
+
+void list::merge(list& other) {
+    if (&other == this || other.empty()) {
+        return;
+    }
+    adopt_nodes_of(other);
+
+    node_base* it = head_.next;
+    node_base* incoming = other.head_.next;
+    while (incoming != &other.head_) {
+        // Skip ahead over everything that stays in front of the next
+        // incoming node; ties keep this list's elements first.
+        const int value = static_cast<node*>(incoming)->value;
+        while (it != &head_ && !(value < static_cast<node*>(it)->value)) {
+            it = it->next;
+        }
+        if (it == &head_) {
+            transfer(&head_, incoming, &other.head_);
+            break;
+        }
+        // Move the whole run of incoming nodes that sorts before it.
+        const int bound = static_cast<node*>(it)->value;
+        node_base* run_end = incoming->next;
+        while (run_end != &other.head_ && static_cast<node*>(run_end)->value < bound) {
+            run_end = run_end->next;
+        }
+        transfer(it, incoming, run_end);
+        incoming = run_end;
+    }
+    size_ += other.size_;
+    other.size_ = 0;
+}
+
+list list::split(size_t pos) {
+    list tail;
+    if (pos >= size_) {
+        return tail;
+    }
+    node_base* cut;
+    if (pos <= size_ / 2) {
+        cut = head_.next;
+        for (size_t i = 0; i < pos; ++i) {
+            cut = cut->next;
+        }
+    } else {
+        cut = &head_;
+        for (size_t i = size_; i > pos; --i) {
+            cut = cut->prev;
+        }
+    }
+    tail.splice(tail.end(), *this, const_iterator(cut), end(), size_ - pos);
+    return tail;
+}
+
+
+list::node* list::create_node(const int& value) {
+    node* n = ::new (pool_.allocate()) node;
+    n->value = value;
+    return n;
+}
+
+void list::destroy_node(node_base* n) {
+    static_cast<node*>(n)->~node();
+    pool_.deallocate(n);
+}
+
+void list::link_before(node_base* pos, node_base* n) {
+    n->next = pos;
+    n->prev = pos->prev;
+    pos->prev->next = n;
+    pos->prev = n;
+    ++size_;
+}
+
+// Builds the whole run off to the side and links it in with a single splice.
+void list::append_filled(size_t count, const int& value) {
+    if (count == 0) {
+        return;
+    }
+    const int filler = value;
+    pool_.expect(count);
+
+    node_base* first = create_node(filler);
+    node_base* last = first;
+    for (size_t i = 1; i < count; ++i) {
+        node_base* n = create_node(filler);
+        n->prev = last;
+        last->next = n;
+        last = n;
+    }
+
+    first->prev = head_.prev;
+    head_.prev->next = first;
+    last->next = &head_;
+    head_.prev = last;
+    size_ += count;
+}
+
+void list::unlink(node_base* n) {
+    n->prev->next = n->next;
+    n->next->prev = n->prev;
+    --size_;
+}
+
+void list::erase(node_base* n) {
+    unlink(n);
+    destroy_node(n);
+}
+
+// Relinks [first, last) in front of pos. The range may come from another
+// ring; sizes are the caller's business. Moving a range in front of its own
+// first node or of its end leaves everything where it is.
+void list::transfer(node_base* pos, node_base* first, node_base* last) {
+    if (pos == first || pos == last || first == last) {
+        return;
+    }
+    node_base* tail = last->prev;
+
+    first->prev->next = last;
+    last->prev = first->prev;
+
+    first->prev = pos->prev;
+    tail->next = pos;
+    pos->prev->next = first;
+    pos->prev = tail;
+}
+
+// Nodes moving in from other must be releasable through this list's pool.
+void list::adopt_nodes_of(list& other) {
+    pool_.share_with(other.pool_);
+}
+
+void list::reset_head() {
+    head_.prev = &head_;
+    head_.next = &head_;
+}
+
+// Sorting only maintains next links; this restores prev and closes the ring.
+void list::relink_chain(node_base* first) {
+    node_base* prev = &head_;
+    for (node_base* it = first; it != nullptr; it = it->next) {
+        it->prev = prev;
+        prev->next = it;
+        prev = it;
+    }
+    prev->next = &head_;
+    head_.prev = prev;
+}
+
+// Like merge_sorted, but links both directions and closes the ring at head_.
+void list::merge_into_ring(node_base* first, node_base* second) {
+    node_base* tail = &head_;
+    while (first != nullptr && second != nullptr) {
+        node_base* taken;
+        // Take from first on ties to keep the sort stable.
+        if (static_cast<node*>(second)->value < static_cast<node*>(first)->value) {
+            taken = second;
+            second = second->next;
+        } else {
+            taken = first;
+            first = first->next;
+        }
+        tail->next = taken;
+        taken->prev = tail;
+        tail = taken;
+    }
+    for (node_base* it = (first != nullptr) ? first : second; it != nullptr; it = it->next) {
+        tail->next = it;
+        it->prev = tail;
+        tail = it;
+    }
+    tail->next = &head_;
+    head_.prev = tail;
+}
+
+bool list::is_sorted() const {
+    for (const node_base* it = head_.next; it->next != &head_; it = it->next) {
+        if (static_cast<const node*>(it->next)->value < static_cast<const node*>(it)->value) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Strictly descending input is sorted by flipping every link. Equal
+// neighbours would have their order swapped, so they fall through to the
+// merge sort.
+bool list::reverse_if_descending() {
+    for (const node_base* it = head_.next; it->next != &head_; it = it->next) {
+        if (!(static_cast<const node*>(it->next)->value < static_cast<const node*>(it)->value)) {
+            return false;
+        }
+    }
+    node_base* it = &head_;
+    do {
+        std::swap(it->prev, it->next);
+        it = it->prev;
+    } while (it != &head_);
+    return true;
+}
+
+list::node_base* list::merge_sorted(node_base* first, node_base* second) {
+    if (first == nullptr) {
+        return second;
+    }
+    if (second == nullptr) {
+        return first;
+    }
+    // Keys are cached in locals: the link stores below could otherwise alias
+    // them and force a reload of both values on every step.
+    int first_value = static_cast<node*>(first)->value;
+    int second_value = static_cast<node*>(second)->value;
+    // Runs are followed along their existing links and only the node at a
+    // switch point is rewritten, so long runs do not dirty every cache line.
+    node_base merged;
+    node_base* tail = &merged;
+    while (true) {
+        // Take from first on ties to keep the sort stable.
+        if (second_value < first_value) {
+            tail->next = second;
+            do {
+                tail = second;
+                second = second->next;
+                if (second == nullptr) {
+                    tail->next = first;
+                    return merged.next;
+                }
+                second_value = static_cast<node*>(second)->value;
+            } while (second_value < first_value);
+        } else {
+            tail->next = first;
+            do {
+                tail = first;
+                first = first->next;
+                if (first == nullptr) {
+                    tail->next = second;
+                    return merged.next;
+                }
+                first_value = static_cast<node*>(first)->value;
+            } while (!(second_value < first_value));
+        }
+    }
+}
+
+}  // namespace task
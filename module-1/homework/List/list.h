@@ -1,5 +1,9 @@
 #pragma once
 #include <cstddef>
+#include <iterator>
+#include <vector>
+
+#include "node_pool.h"
 
 
 namespace task {
@@ -7,13 +11,155 @@ namespace task {
 
 class list {
 
+    // Nodes form a ring through head_, which is a sentinel and never holds a value.
+    struct node_base {
+        node_base* prev;
+        node_base* next;
+    };
+
+    struct node : node_base {
+        int value;
+    };
+
 public:
 
+    class const_iterator;
+
+    class iterator {
+
+    public:
+
+        using iterator_category = std::bidirectional_iterator_tag;
+        using value_type = int;
+        using difference_type = std::ptrdiff_t;
+        using pointer = int*;
+        using reference = int&;
+
+        iterator() = default;
+
+        reference operator*() const {
+            return static_cast<node*>(node_)->value;
+        }
+
+        pointer operator->() const {
+            return &static_cast<node*>(node_)->value;
+        }
+
+        iterator& operator++() {
+            node_ = node_->next;
+            return *this;
+        }
+
+        iterator operator++(int) {
+            iterator copy = *this;
+            node_ = node_->next;
+            return copy;
+        }
+
+        iterator& operator--() {
+            node_ = node_->prev;
+            return *this;
+        }
+
+        iterator operator--(int) {
+            iterator copy = *this;
+            node_ = node_->prev;
+            return copy;
+        }
+
+        friend bool operator==(const iterator& lhs, const iterator& rhs) {
+            return lhs.node_ == rhs.node_;
+        }
+
+        friend bool operator!=(const iterator& lhs, const iterator& rhs) {
+            return lhs.node_ != rhs.node_;
+        }
+
+    private:
+
+        friend class list;
+        friend class const_iterator;
+
+        explicit iterator(node_base* n) : node_(n) {
+        }
+
+        node_base* node_ = nullptr;
+
+    };
+
+    class const_iterator {
+
+    public:
+
+        using iterator_category = std::bidirectional_iterator_tag;
+        using value_type = int;
+        using difference_type = std::ptrdiff_t;
+        using pointer = const int*;
+        using reference = const int&;
+
+        const_iterator() = default;
+
+        const_iterator(const iterator& it) : node_(it.node_) {
+        }
+
+        reference operator*() const {
+            return static_cast<const node*>(node_)->value;
+        }
+
+        pointer operator->() const {
+            return &static_cast<const node*>(node_)->value;
+        }
+
+        const_iterator& operator++() {
+            node_ = node_->next;
+            return *this;
+        }
+
+        const_iterator operator++(int) {
+            const_iterator copy = *this;
+            node_ = node_->next;
+            return copy;
+        }
+
+        const_iterator& operator--() {
+            node_ = node_->prev;
+            return *this;
+        }
+
+        const_iterator operator--(int) {
+            const_iterator copy = *this;
+            node_ = node_->prev;
+            return copy;
+        }
+
+        friend bool operator==(const const_iterator& lhs, const const_iterator& rhs) {
+            return lhs.node_ == rhs.node_;
+        }
+
+        friend bool operator!=(const const_iterator& lhs, const const_iterator& rhs) {
+            return lhs.node_ != rhs.node_;
+        }
+
+    private:
+
+        friend class list;
+
+        explicit const_iterator(node_base* n) : node_(n) {
+        }
+
+        node_base* node_ = nullptr;
+
+    };
+
+
     list();
     list(size_t count, const int& value = int());
+    list(const list& other);
+    list(list&& other) noexcept;
 
     ~list();
     list& operator=(const list& other);
+    list& operator=(list&& other) noexcept;
 
 
     int& front();
@@ -23,6 +169,13 @@ public:
     const int& back() const;
 
 
+    iterator begin();
+    const_iterator begin() const;
+
+    iterator end();
+    const_iterator end() const;
+
+
     bool empty() const;
     size_t size() const;
     void clear();
@@ -37,14 +190,92 @@ public:
 
 
     void remove(const int& value);
+    // Erases every element found in sorted_values, which must be sorted ascending.
+    void remove(const std::vector<int>& sorted_values);
     void unique();
     void sort();
 
-    // Your code goes here?..
+    // Stable LSD radix sort into 256 buckets per byte. Passes where every
+    // element has the same byte are skipped, which makes it the better choice
+    // for narrow or few-unique keys.
+    void radix_sort();
+
+
+    // Lists that nodes moved between go on allocating from, and freeing to,
+    // one pool. It locks itself once shared, so each list may afterwards be
+    // used from a different thread; a single list still may not. Merging two
+    // pools, the first time their lists exchange nodes, adds a pass over
+    // their blocks, one per up to 16384 nodes, to the costs below.
+    //
+    // Moves all of other in front of pos. O(1).
+    void splice(const_iterator pos, list& other);
+    // Moves the element at it from other in front of pos. O(1).
+    void splice(const_iterator pos, list& other, const_iterator it);
+    // Moves [first, last) from other in front of pos. O(1) when other is
+    // *this, otherwise linear in the range length, which is counted to keep
+    // size() exact.
+    void splice(const_iterator pos, list& other, const_iterator first, const_iterator last);
+    // Same, for callers that already know count == distance(first, last). O(1).
+    void splice(const_iterator pos, list& other, const_iterator first, const_iterator last,
+                size_t count);
+
+    // Merges sorted other into this sorted list by relinking nodes; stable,
+    // linear, no allocation. other is left empty.
+    void merge(list& other);
+
+    // Cuts the list after its first pos elements and returns the rest.
+    // O(min(pos, size() - pos)) to find the cut, O(1) to make it. The two
+    // parts share a pool, as after splice, so each may go to a different
+    // thread.
+    list split(size_t pos);
+
+
+    // Erases every element for which pred(value) is true, in a single pass.
+    template <class Predicate>
+    void remove_if(Predicate pred) {
+        // Survivors keep their links; only the node after a removed run is
+        // rewired, so long kept runs are read but never written.
+        node_base* kept = &head_;
+        for (node_base* it = head_.next; it != &head_;) {
+            node_base* next = it->next;
+            if (pred(static_cast<node*>(it)->value)) {
+                destroy_node(it);
+                --size_;
+            } else {
+                if (it->prev != kept) {
+                    kept->next = it;
+                    it->prev = kept;
+                }
+                kept = it;
+            }
+            it = next;
+        }
+        kept->next = &head_;
+        head_.prev = kept;
+    }
 
 private:
 
-    // Your code goes here...
+    node* create_node(const int& value);
+    void destroy_node(node_base* n);
+    void link_before(node_base* pos, node_base* n);
+    void append_filled(size_t count, const int& value);
+    void unlink(node_base* n);
+    void erase(node_base* n);
+    void transfer(node_base* pos, node_base* first, node_base* last);
+    void adopt_nodes_of(list& other);
+    void reset_head();
+    void relink_chain(node_base* first);
+    void merge_into_ring(node_base* first, node_base* second);
+    bool is_sorted() const;
+    bool reverse_if_descending();
+
+    static node_base* merge_sorted(node_base* first, node_base* second);
+
+
+    node_base head_;
+    size_t size_;
+    shared_node_pool<node> pool_;
 
 };
 
@@ -0,0 +1,425 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <new>
+#include <utility>
+
+
+namespace task {
+
+
+// Slab allocator for fixed-size list nodes.
+//
+// Nodes are carved out of cache-line-aligned blocks, released nodes go to an
+// intrusive free list and are handed out again before the block is bumped any
+// further. Blocks are returned to the heap only by the destructor, so a list
+// that is cleared and refilled does not touch malloc at all.
+template <class Node>
+class node_pool {
+
+public:
+
+    static constexpr size_t cache_line = 64;
+
+    node_pool() = default;
+    node_pool(const node_pool&) = delete;
+    node_pool& operator=(const node_pool&) = delete;
+
+    node_pool(node_pool&& other) noexcept {
+        swap(other);
+    }
+
+    node_pool& operator=(node_pool&& other) noexcept {
+        node_pool(std::move(other)).swap(*this);
+        return *this;
+    }
+
+    ~node_pool() {
+        while (blocks_ != nullptr) {
+            block_header* next = blocks_->next;
+            ::operator delete(blocks_->raw);
+            blocks_ = next;
+        }
+    }
+
+
+    // Returns uninitialized storage for one Node.
+    void* allocate() {
+        if (free_ != nullptr) {
+            free_slot* slot = free_;
+            free_ = slot->next;
+            return slot;
+        }
+        if (cursor_ == end_) {
+            next_region();
+        }
+        void* slot = cursor_;
+        cursor_ += slot_size;
+        return slot;
+    }
+
+    // Announces that about count nodes are about to be requested, so block
+    // sizes skip the gradual ramp-up. Blocks stay capped at max_block_nodes:
+    // one huge block would be mmap-ed and faulted in afresh every time.
+    void expect(size_t count) {
+        while (next_block_nodes_ < max_block_nodes && next_block_nodes_ < count) {
+            next_block_nodes_ *= 2;
+        }
+    }
+
+    // Takes back storage obtained from allocate(); the Node must already be destroyed.
+    void deallocate(void* p) noexcept {
+        free_slot* slot = static_cast<free_slot*>(p);
+        if (free_ == nullptr) {
+            free_tail_ = slot;
+        }
+        slot->next = free_;
+        free_ = slot;
+    }
+
+    // Forgets every outstanding node at once and keeps the blocks for reuse.
+    // Only valid when no node handed out by this pool is alive any more.
+    void reset() noexcept {
+        free_ = nullptr;
+        cursor_ = nullptr;
+        end_ = nullptr;
+        reuse_ = blocks_;
+        ++epoch_;
+    }
+
+    // Takes over every block of other, leaving it empty. Nodes handed out by
+    // either pool may then be returned to this one. Costs one pass over the
+    // blocks of both pools, however many slots they hold: other's free list
+    // is linked in whole, and its spare blocks, the rest of its bump region
+    // included, join this pool's reuse chain.
+    void adopt(node_pool& other) noexcept {
+        if (other.blocks_ == nullptr) {
+            return;
+        }
+        if (other.free_ != nullptr) {
+            other.free_tail_->next = free_;
+            if (free_ == nullptr) {
+                free_tail_ = other.free_tail_;
+            }
+            free_ = other.free_;
+        }
+
+        // The block other is bumping through, if any slots are left in it.
+        block_header* partial = nullptr;
+        if (other.cursor_ != other.end_) {
+            if (cursor_ == end_) {
+                cursor_ = other.cursor_;
+                end_ = other.end_;
+            } else {
+                partial = other.blocks_;
+                while (partial->last != other.end_) {
+                    partial = partial->next;
+                }
+            }
+        }
+
+        // Rebuild the chain as: blocks in use, other's then ours, followed by
+        // the reuse chain: partial, other's spare blocks, then ours.
+        block_header* head = nullptr;
+        block_header** tail = &head;
+        for (block_header* block = other.blocks_; block != other.reuse_;) {
+            block_header* next = block->next;
+            if (block != partial) {
+                block->resume = block->first;
+                *tail = block;
+                tail = &block->next;
+            }
+            block = next;
+        }
+        for (block_header* block = blocks_; block != reuse_; block = block->next) {
+            *tail = block;
+            tail = &block->next;
+        }
+        block_header** reuse = tail;
+        if (partial != nullptr) {
+            partial->resume = other.cursor_;
+            partial->resume_epoch = epoch_;
+            *tail = partial;
+            tail = &partial->next;
+        }
+        for (block_header* block = other.reuse_; block != nullptr; block = block->next) {
+            if (block->resume_epoch != other.epoch_) {
+                block->resume = block->first;
+            }
+            block->resume_epoch = epoch_;
+            *tail = block;
+            tail = &block->next;
+        }
+        *tail = reuse_;
+        reuse_ = *reuse;
+        blocks_ = head;
+
+        other.blocks_ = nullptr;
+        other.free_ = nullptr;
+        other.cursor_ = nullptr;
+        other.end_ = nullptr;
+        other.reuse_ = nullptr;
+    }
+
+    void swap(node_pool& other) noexcept {
+        std::swap(blocks_, other.blocks_);
+        std::swap(free_, other.free_);
+        std::swap(free_tail_, other.free_tail_);
+        std::swap(cursor_, other.cursor_);
+        std::swap(end_, other.end_);
+        std::swap(reuse_, other.reuse_);
+        std::swap(next_block_nodes_, other.next_block_nodes_);
+        std::swap(epoch_, other.epoch_);
+    }
+
+    // Number of blocks requested from the heap so far.
+    size_t block_count() const {
+        size_t count = 0;
+        for (block_header* block = blocks_; block != nullptr; block = block->next) {
+            ++count;
+        }
+        return count;
+    }
+
+private:
+
+    struct free_slot {
+        free_slot* next;
+    };
+
+    struct block_header {
+        block_header* next;
+        void* raw;
+        char* first;
+        char* last;
+        // Where bumping picks up when the block is reached through reuse_,
+        // if that happens before the pool's epoch moves on; from first
+        // otherwise. Only an adopted, half-used block starts past first.
+        char* resume;
+        size_t resume_epoch;
+    };
+
+    static constexpr size_t slot_size =
+        sizeof(Node) < sizeof(free_slot) ? sizeof(free_slot) : sizeof(Node);
+    static constexpr size_t slot_align =
+        alignof(Node) < alignof(free_slot) ? alignof(free_slot) : alignof(Node);
+    static_assert(slot_size % slot_align == 0, "node size must be a multiple of its alignment");
+
+    static constexpr size_t min_block_nodes = 32;
+    static constexpr size_t max_block_nodes = 16384;
+
+
+    static size_t align_up(size_t value, size_t alignment) {
+        return (value + alignment - 1) / alignment * alignment;
+    }
+
+    // Moves the bump region to a block kept by reset() or adopted with room
+    // to spare, or to a fresh one.
+    void next_region() {
+        if (reuse_ != nullptr) {
+            cursor_ = reuse_->resume_epoch == epoch_ ? reuse_->resume : reuse_->first;
+            end_ = reuse_->last;
+            reuse_ = reuse_->next;
+            return;
+        }
+        grow();
+    }
+
+    void grow() {
+        const size_t header = align_up(sizeof(block_header), cache_line);
+        const size_t bytes = header + next_block_nodes_ * slot_size;
+
+        // operator new only guarantees max_align_t, so over-allocate and align by hand.
+        void* raw = ::operator new(bytes + cache_line - 1);
+        uintptr_t address = reinterpret_cast<uintptr_t>(raw);
+        char* base = static_cast<char*>(raw) + (align_up(address, cache_line) - address);
+
+        block_header* block = ::new (base) block_header;
+        block->next = blocks_;
+        block->raw = raw;
+        block->first = base + header;
+        block->last = block->first + next_block_nodes_ * slot_size;
+        block->resume = block->first;
+        block->resume_epoch = epoch_;
+        blocks_ = block;
+
+        cursor_ = block->first;
+        end_ = block->last;
+        if (next_block_nodes_ < max_block_nodes) {
+            next_block_nodes_ *= 2;
+        }
+    }
+
+
+    block_header* blocks_ = nullptr;
+    free_slot* free_ = nullptr;
+    // Last slot of the free list; stale while free_ is null.
+    free_slot* free_tail_ = nullptr;
+    char* cursor_ = nullptr;
+    char* end_ = nullptr;
+    block_header* reuse_ = nullptr;
+    size_t next_block_nodes_ = min_block_nodes;
+    // Bumped by reset(), which makes every resume point stale.
+    size_t epoch_ = 0;
+
+};
+
+
+
+// Handle to a node_pool that several lists may end up drawing from.
+//
+// Each list starts with a pool of its own, created on first use. Moving nodes
+// from one list to another calls share_with(), which merges the two pools and
+// lets both lists point at the result, so nodes can be freed by whichever list
+// holds them.
+//
+// Lists joined this way may still be used from different threads, e.g. after
+// split() made shards of one work queue, so a shared group guards its pool with
+// a mutex. A handle that is alone in its group skips the lock altogether.
+//
+// Merged pools form a union-find forest: an absorbed group forwards to the one
+// that took its blocks, and handles move to the root lazily on their next use.
+template <class Node>
+class shared_node_pool {
+
+public:
+
+    shared_node_pool() = default;
+    shared_node_pool(const shared_node_pool&) = delete;
+    shared_node_pool& operator=(const shared_node_pool&) = delete;
+
+    ~shared_node_pool() {
+        release(group_);
+    }
+
+
+    void* allocate() {
+        create();
+        std::unique_lock<std::mutex> lock = lock_root();
+        return group_->pool.allocate();
+    }
+
+    void deallocate(void* p) noexcept {
+        std::unique_lock<std::mutex> lock = lock_root();
+        group_->pool.deallocate(p);
+    }
+
+    void expect(size_t count) {
+        create();
+        std::unique_lock<std::mutex> lock = lock_root();
+        group_->pool.expect(count);
+    }
+
+    // True when no other handle draws from the same pool, i.e. every node it
+    // has handed out belongs to the caller.
+    bool exclusive() noexcept {
+        if (group_ == nullptr) {
+            return true;
+        }
+        std::unique_lock<std::mutex> lock = lock_root();
+        return group_->refs.load(std::memory_order_acquire) == 1;
+    }
+
+    // Same as node_pool::reset(); only valid when exclusive().
+    void reset() noexcept {
+        if (group_ != nullptr) {
+            group_->pool.reset();
+        }
+    }
+
+    // Afterwards this and other allocate from, and free to, the same pool.
+    void share_with(shared_node_pool& other) {
+        create();
+        other.create();
+        for (;;) {
+            lock_root();
+            other.lock_root();
+            if (group_ == other.group_) {
+                return;
+            }
+            // Another thread may merge either root away before both are held.
+            std::lock(group_->mutex, other.group_->mutex);
+            if (group_->forward == nullptr && other.group_->forward == nullptr) {
+                break;
+            }
+            group_->mutex.unlock();
+            other.group_->mutex.unlock();
+        }
+
+        group* absorbed = other.group_;
+        group_->pool.adopt(absorbed->pool);
+        absorbed->forward = group_;
+        group_->refs.fetch_add(1, std::memory_order_relaxed);
+        group_->shared.store(true, std::memory_order_relaxed);
+        absorbed->shared.store(true, std::memory_order_relaxed);
+        group_->mutex.unlock();
+        absorbed->mutex.unlock();
+        other.lock_root();
+    }
+
+    void swap(shared_node_pool& other) noexcept {
+        std::swap(group_, other.group_);
+    }
+
+private:
+
+    struct group {
+        node_pool<Node> pool;
+        std::mutex mutex;
+        std::atomic<size_t> refs{1};
+        // Set once a second handle may reach the group, cleared by the next
+        // lock_root() that finds the other handles gone. Only while it is set
+        // are pool and forward guarded by mutex.
+        std::atomic<bool> shared{false};
+        group* forward = nullptr;
+    };
+
+
+    void create() {
+        if (group_ == nullptr) {
+            group_ = new group;
+        }
+    }
+
+    // Moves this handle to the root of its group and, if the group is shared,
+    // returns holding the root's mutex. A root whose only reference is this
+    // handle is no longer shared: nothing else can reach it, not even through
+    // a forward link, so it goes back to taking no lock.
+    std::unique_lock<std::mutex> lock_root() noexcept {
+        for (;;) {
+            if (!group_->shared.load(std::memory_order_acquire)) {
+                return std::unique_lock<std::mutex>();
+            }
+            std::unique_lock<std::mutex> lock(group_->mutex);
+            group* root = group_->forward;
+            if (root == nullptr) {
+                if (group_->refs.load(std::memory_order_acquire) == 1) {
+                    group_->shared.store(false, std::memory_order_relaxed);
+                    return std::unique_lock<std::mutex>();
+                }
+                return lock;
+            }
+            // group_ keeps root alive through its forward link until released.
+            root->refs.fetch_add(1, std::memory_order_relaxed);
+            lock.unlock();
+            release(group_);
+            group_ = root;
+        }
+    }
+
+    static void release(group* g) noexcept {
+        while (g != nullptr && g->refs.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+            group* forward = g->forward;
+            delete g;
+            g = forward;
+        }
+    }
+
+
+    group* group_ = nullptr;
+
+};
+
+}  // namespace task
@@ -3,9 +3,11 @@
 #include <list>
 #include <random>
 #include <string>
+#include <thread>
 #include <vector>
 
 #include "list.h"
+#include "unrolled_list.h"
 
 size_t RandomUInt(size_t max = -1) {
     static std::mt19937 rand(std::random_device{}());
@@ -32,8 +34,9 @@ void RandomFill(T& container, size_t count, size_t max = -1) {
 }
 
 
-std::list<int> ToStdList(const task::list& list_task) {
-    task::list list_task_copy = list_task;
+template <class List>
+std::list<int> ToStdList(const List& list_task) {
+    List list_task_copy = list_task;
     std::list<int> list_std;
     while (!list_task_copy.empty()) {
         list_std.push_back(list_task_copy.front());
@@ -161,6 +164,214 @@ int main() {
         ASSERT_EQUAL_MSG(ToStdList(list_task2), list_std2, "list::swap")
     }
 
+    {
+        // Random (with negatives), already sorted, reversed and few-unique inputs.
+        for (size_t shape = 0; shape < 4; ++shape) {
+            std::list<int> list_std;
+            RandomFill(list_std, RandomUInt(1000, 5000), shape == 3 ? 4 : -1);
+            if (shape == 1) {
+                list_std.sort();
+            } else if (shape == 2) {
+                list_std.sort();
+                list_std.reverse();
+            }
+
+            task::list list_merge;
+            task::list list_radix;
+            for (int value : list_std) {
+                list_merge.push_back(value);
+                list_radix.push_back(value);
+            }
+
+            list_merge.sort();
+            list_radix.radix_sort();
+            list_std.sort();
+
+            ASSERT_EQUAL_MSG(ToStdList(list_merge), list_std, "list::sort")
+            ASSERT_EQUAL_MSG(ToStdList(list_radix), list_std, "list::radix_sort")
+        }
+    }
+
+    {
+        task::list list_task;
+        RandomFill(list_task, RandomUInt(1000, 5000), 100);
+        std::list<int> list_std = ToStdList(list_task);
+
+        list_task.remove_if([](int value) { return value % 3 == 0; });
+        list_std.remove_if([](int value) { return value % 3 == 0; });
+        ASSERT_EQUAL_MSG(ToStdList(list_task), list_std, "list::remove_if")
+
+        std::vector<int> values;
+        RandomFill(values, RandomUInt(1, 20), 100);
+        std::sort(values.begin(), values.end());
+        list_task.remove(values);
+        list_std.remove_if([&values](int value) {
+            return std::binary_search(values.begin(), values.end(), value);
+        });
+        ASSERT_EQUAL_MSG(ToStdList(list_task), list_std, "list::remove(sorted values)")
+
+        size_t count = list_std.size() + RandomUInt(1000, 5000);
+        list_task.resize(count);
+        list_std.resize(count);
+        ASSERT_EQUAL_MSG(ToStdList(list_task), list_std, "list::resize")
+        list_task.push_back(1);
+        list_std.push_back(1);
+        ASSERT_EQUAL_MSG(ToStdList(list_task), list_std, "list::resize")
+    }
+
+    {
+        task::list list_task;
+        std::list<int> list_std;
+        {
+            // The donors die first: spliced nodes must outlive the list they came from.
+            task::list donor_task;
+            RandomFill(donor_task, RandomUInt(10, 100));
+            std::list<int> donor_std = ToStdList(donor_task);
+            list_task.splice(list_task.end(), donor_task);
+            list_std.splice(list_std.end(), donor_std);
+            ASSERT_TRUE(donor_task.empty() && donor_task.size() == 0)
+
+            task::list range_task;
+            RandomFill(range_task, RandomUInt(10, 100));
+            std::list<int> range_std = ToStdList(range_task);
+            auto first_task = std::next(range_task.begin(), 3);
+            auto last_task = std::prev(range_task.end(), 2);
+            auto first_std = std::next(range_std.begin(), 3);
+            auto last_std = std::prev(range_std.end(), 2);
+            list_task.splice(std::next(list_task.begin()), range_task, first_task, last_task);
+            list_std.splice(std::next(list_std.begin()), range_std, first_std, last_std);
+            ASSERT_EQUAL_MSG(ToStdList(range_task), range_std, "list::splice(range)")
+            ASSERT_TRUE(range_task.size() == range_std.size())
+
+            list_task.splice(list_task.begin(), range_task, std::prev(range_task.end()));
+            list_std.splice(list_std.begin(), range_std, std::prev(range_std.end()));
+            ASSERT_TRUE(range_task.size() == range_std.size())
+        }
+        ASSERT_EQUAL_MSG(ToStdList(list_task), list_std, "list::splice")
+        ASSERT_TRUE(list_task.size() == list_std.size())
+
+        // Rotate within one list.
+        list_task.splice(list_task.begin(), list_task, std::prev(list_task.end(), 5),
+                         list_task.end());
+        list_std.splice(list_std.begin(), list_std, std::prev(list_std.end(), 5), list_std.end());
+        ASSERT_EQUAL_MSG(ToStdList(list_task), list_std, "list::splice(self)")
+
+        // Splicing an element in front of itself must not touch the links.
+        list_task.splice(std::next(list_task.begin()), list_task, std::next(list_task.begin()));
+        list_std.splice(std::next(list_std.begin()), list_std, std::next(list_std.begin()));
+        ASSERT_EQUAL_MSG(ToStdList(list_task), list_std, "list::splice(self, it)")
+        ASSERT_TRUE(list_task.size() == list_std.size())
+
+        size_t pos = RandomUInt(list_std.size());
+        task::list tail_task = list_task.split(pos);
+        std::list<int> tail_std;
+        tail_std.splice(tail_std.end(), list_std, std::next(list_std.begin(), pos), list_std.end());
+        ASSERT_EQUAL_MSG(ToStdList(list_task), list_std, "list::split")
+        ASSERT_EQUAL_MSG(ToStdList(tail_task), tail_std, "list::split")
+        ASSERT_TRUE(list_task.size() == list_std.size() && tail_task.size() == tail_std.size())
+
+        list_task.sort();
+        tail_task.sort();
+        list_std.sort();
+        tail_std.sort();
+        list_task.merge(tail_task);
+        list_std.merge(tail_std);
+        ASSERT_EQUAL_MSG(ToStdList(list_task), list_std, "list::merge")
+        ASSERT_TRUE(tail_task.empty() && list_task.size() == list_std.size())
+
+        list_task.clear();
+        tail_task.push_back(1);
+        ASSERT_TRUE(tail_task.size() == 1 && tail_task.front() == 1)
+    }
+
+    {
+        // Merging pools keeps the donor's spare slots where they are: blocks
+        // kept by clear(), the rest of a half-used block and the free list
+        // must all be handed out again, each slot once.
+        task::list list_task;
+        RandomFill(list_task, 100);
+        list_task.clear();
+        RandomFill(list_task, 10);
+        list_task.pop_back();
+        std::list<int> list_std = ToStdList(list_task);
+        {
+            task::list donor_task;
+            RandomFill(donor_task, 50000);
+            donor_task.clear();
+            RandomFill(donor_task, 3000);
+            for (int i = 0; i < 1000; ++i) {
+                donor_task.pop_front();
+            }
+            std::list<int> donor_std = ToStdList(donor_task);
+
+            list_task.splice(list_task.end(), donor_task, donor_task.begin());
+            list_std.splice(list_std.end(), donor_std, donor_std.begin());
+            for (int i = 0; i < 100000; ++i) {
+                list_task.push_back(i);
+                list_std.push_back(i);
+                donor_task.push_front(i);
+                donor_std.push_front(i);
+            }
+            ASSERT_EQUAL_MSG(ToStdList(list_task), list_std, "list::splice(adopted pool)")
+            ASSERT_EQUAL_MSG(ToStdList(donor_task), donor_std, "list::splice(adopted pool)")
+        }
+
+        list_task.clear();
+        list_std.clear();
+        for (int i = 0; i < 200000; ++i) {
+            list_task.push_back(i);
+            list_std.push_back(i);
+        }
+        ASSERT_EQUAL_MSG(ToStdList(list_task), list_std, "list::clear(adopted pool)")
+    }
+
+    {
+        // Shards cut from one queue share its pool; each is then worked on by a thread of its own.
+        const size_t SHARD_COUNT = 4;
+        const int OP_COUNT = 20000;
+
+        task::list queue;
+        RandomFill(queue, RandomUInt(1000, 5000));
+        std::vector<task::list> shards_task;
+        while (shards_task.size() + 1 < SHARD_COUNT) {
+            shards_task.push_back(queue.split(queue.size() / 2));
+        }
+        shards_task.push_back(std::move(queue));
+        std::vector<std::list<int>> shards_std;
+        for (const task::list& shard : shards_task) {
+            shards_std.push_back(ToStdList(shard));
+        }
+
+        std::vector<std::thread> workers;
+        for (size_t i = 0; i < SHARD_COUNT; ++i) {
+            workers.emplace_back([&shard_task = shards_task[i], &shard_std = shards_std[i]] {
+                for (int op = 0; op < OP_COUNT; ++op) {
+                    shard_task.push_back(op);
+                    shard_std.push_back(op);
+                    if (op % 3 != 0) {
+                        shard_task.pop_front();
+                        shard_std.pop_front();
+                    }
+                }
+            });
+        }
+        for (std::thread& worker : workers) {
+            worker.join();
+        }
+        for (size_t i = 0; i < SHARD_COUNT; ++i) {
+            ASSERT_EQUAL_MSG(ToStdList(shards_task[i]), shards_std[i], "list::split(threads)")
+            ASSERT_TRUE(shards_task[i].size() == shards_std[i].size())
+        }
+
+        for (size_t i = 1; i < SHARD_COUNT; ++i) {
+            shards_task[0].splice(shards_task[0].end(), shards_task[i]);
+        }
+        shards_task.resize(1);
+        shards_task[0].clear();
+        shards_task[0].push_back(1);
+        ASSERT_TRUE(shards_task[0].size() == 1 && shards_task[0].front() == 1)
+    }
+
     {
         const size_t LIST_COUNT = 5;
         const size_t ITER_COUNT = 30000;
@@ -209,4 +420,65 @@ int main() {
             }
         }
     }
+
+    {
+        const size_t ITER_COUNT = 30000;
+
+        task::unrolled_list list_task;
+        std::list<int> list_std;
+
+        for (size_t iter = 0; iter < ITER_COUNT; ++iter) {
+            size_t case_type = list_task.empty() ? 0 : RandomUInt(5);
+            switch (case_type) {
+                case 0:
+                case 1: {
+                    auto val = RandomUInt(50);
+                    if (TossCoin()) {
+                        list_task.push_back(val);
+                        list_std.push_back(val);
+                    } else {
+                        list_task.push_front(val);
+                        list_std.push_front(val);
+                    }
+                    break;
+                }
+                case 2: {
+                    if (TossCoin()) {
+                        list_task.pop_back();
+                        list_std.pop_back();
+                    } else {
+                        list_task.pop_front();
+                        list_std.pop_front();
+                    }
+                    break;
+                }
+                case 3: {
+                    list_task.remove(list_task.back());
+                    list_std.remove(list_std.back());
+                    break;
+                }
+                case 4: {
+                    list_task.unique();
+                    list_std.unique();
+                    break;
+                }
+                case 5: {
+                    size_t count = RandomUInt(list_std.size() * 2);
+                    list_task.resize(count);
+                    list_std.resize(count);
+                    break;
+                }
+            }
+            ASSERT_TRUE(list_task.size() == list_std.size())
+            if (!list_std.empty()) {
+                ASSERT_TRUE(list_task.front() == list_std.front())
+                ASSERT_TRUE(list_task.back() == list_std.back())
+            }
+        }
+        ASSERT_EQUAL_MSG(ToStdList(list_task), list_std, "unrolled_list")
+
+        list_task.sort();
+        list_std.sort();
+        ASSERT_EQUAL_MSG(ToStdList(list_task), list_std, "unrolled_list::sort")
+    }
 }
\ No newline at end of file
@@ -0,0 +1,275 @@
+#include "unrolled_list.h"
+
+#include <algorithm>
+#include <new>
+#include <utility>
+#include <vector>
+
+
+namespace task {
+
+
+unrolled_list::unrolled_list() : size_(0) {
+    reset_head();
+}
+
+unrolled_list::unrolled_list(size_t count, const int& value) : unrolled_list() {
+    for (size_t i = 0; i < count; ++i) {
+        push_back(value);
+    }
+}
+
+unrolled_list::unrolled_list(const unrolled_list& other) : unrolled_list() {
+    other.for_each([this](int value) { push_back(value); });
+}
+
+unrolled_list::unrolled_list(unrolled_list&& other) noexcept : unrolled_list() {
+    swap(other);
+}
+
+unrolled_list::~unrolled_list() {
+    clear();
+}
+
+unrolled_list& unrolled_list::operator=(const unrolled_list& other) {
+    if (this != &other) {
+        unrolled_list copy(other);
+        swap(copy);
+    }
+    return *this;
+}
+
+unrolled_list& unrolled_list::operator=(unrolled_list&& other) noexcept {
+    if (this != &other) {
+        clear();
+        swap(other);
+    }
+    return *this;
+}
+
+
+int& unrolled_list::front() {
+    chunk* c = static_cast<chunk*>(head_.next);
+    return c->values[c->first];
+}
+
+const int& unrolled_list::front() const {
+    const chunk* c = static_cast<const chunk*>(head_.next);
+    return c->values[c->first];
+}
+
+int& unrolled_list::back() {
+    chunk* c = static_cast<chunk*>(head_.prev);
+    return c->values[c->last - 1];
+}
+
+const int& unrolled_list::back() const {
+    const chunk* c = static_cast<const chunk*>(head_.prev);
+    return c->values[c->last - 1];
+}
+
+
+bool unrolled_list::empty() const {
+    return size_ == 0;
+}
+
+size_t unrolled_list::size() const {
+    return size_;
+}
+
+void unrolled_list::clear() {
+    pool_.reset();
+    reset_head();
+    size_ = 0;
+}
+
+
+void unrolled_list::push_back(const int& value) {
+    chunk* c = static_cast<chunk*>(head_.prev);
+    if (head_.prev == &head_ || c->last == chunk_capacity) {
+        c = create_chunk(&head_, 0);
+    }
+    c->values[c->last++] = value;
+    ++size_;
+}
+
+void unrolled_list::pop_back() {
+    chunk* c = static_cast<chunk*>(head_.prev);
+    if (--c->last == c->first) {
+        destroy_chunk(c);
+    }
+    --size_;
+}
+
+void unrolled_list::push_front(const int& value) {
+    chunk* c = static_cast<chunk*>(head_.next);
+    if (head_.next == &head_ || c->first == 0) {
+        // Fill a fresh front chunk from its end so further push_front calls stay in it.
+        c = create_chunk(head_.next, chunk_capacity);
+    }
+    c->values[--c->first] = value;
+    ++size_;
+}
+
+void unrolled_list::pop_front() {
+    chunk* c = static_cast<chunk*>(head_.next);
+    if (++c->first == c->last) {
+        destroy_chunk(c);
+    }
+    --size_;
+}
+
+void unrolled_list::resize(size_t count) {
+    while (size_ > count) {
+        chunk* c = static_cast<chunk*>(head_.prev);
+        const size_t excess = size_ - count;
+        const size_t held = c->last - c->first;
+        if (held <= excess) {
+            destroy_chunk(c);
+            size_ -= held;
+        } else {
+            c->last -= static_cast<uint16_t>(excess);
+            size_ = count;
+        }
+    }
+    while (size_ < count) {
+        push_back(int());
+    }
+}
+
+void unrolled_list::swap(unrolled_list& other) {
+    std::swap(head_, other.head_);
+    std::swap(size_, other.size_);
+    pool_.swap(other.pool_);
+
+    if (size_ == 0) {
+        reset_head();
+    } else {
+        head_.next->prev = &head_;
+        head_.prev->next = &head_;
+    }
+    if (other.size_ == 0) {
+        other.reset_head();
+    } else {
+        other.head_.next->prev = &other.head_;
+        other.head_.prev->next = &other.head_;
+    }
+}
+
+
+void unrolled_list::remove(const int& value) {
+    const int target = value;
+    compact([target](int current) { return current != target; });
+}
+
+void unrolled_list::unique() {
+    bool seen = false;
+    int previous = 0;
+    compact([&seen, &previous](int current) {
+        const bool keep = !seen || current != previous;
+        seen = true;
+        previous = current;
+        return keep;
+    });
+}
+
+void unrolled_list::sort() {
+    if (size_ < 2) {
+        return;
+    }
+    // Chunks are arrays already; sorting a flat copy and writing it back keeps
+    // the chunk layout and beats pointer-chasing merges by a wide margin.
+    std::vector<int> values;
+    values.reserve(size_);
+    for_each([&values](int value) { values.push_back(value); });
+    std::sort(values.begin(), values.end());
+
+    auto source = values.begin();
+    for (chunk_base* it = head_.next; it != &head_; it = it->next) {
+        chunk* c = static_cast<chunk*>(it);
+        const size_t held = c->last - c->first;
+        std::copy(source, source + held, c->values + c->first);
+        source += held;
+    }
+}
+
+
+unrolled_list::chunk* unrolled_list::create_chunk(chunk_base* pos, size_t offset) {
+    chunk* c = ::new (pool_.allocate()) chunk;
+    c->first = static_cast<uint16_t>(offset);
+    c->last = static_cast<uint16_t>(offset);
+    c->next = pos;
+    c->prev = pos->prev;
+    pos->prev->next = c;
+    pos->prev = c;
+    return c;
+}
+
+void unrolled_list::destroy_chunk(chunk_base* c) {
+    c->prev->next = c->next;
+    c->next->prev = c->prev;
+    static_cast<chunk*>(c)->~chunk();
+    pool_.deallocate(c);
+}
+
+void unrolled_list::truncate_after(chunk* c, size_t last) {
+    c->last = static_cast<uint16_t>(last);
+    while (c->next != &head_) {
+        destroy_chunk(c->next);
+    }
+}
+
+void unrolled_list::reset_head() {
+    head_.prev = &head_;
+    head_.next = &head_;
+}
+
+// Streams the kept values to the front of the chunk sequence, in order,
+// then frees the chunks left over at the tail. The write position never
+// overtakes the read position, so the pass works in place and leaves every
+// chunk but the first and the last full.
+template <class Keep>
+void unrolled_list::compact(Keep keep) {
+    if (size_ == 0) {
+        return;
+    }
+    chunk* write = static_cast<chunk*>(head_.next);
+    size_t w = write->first;
+    size_t kept = 0;
+
+    for (chunk_base* it = head_.next; it != &head_;) {
+        chunk* read = static_cast<chunk*>(it);
+        chunk_base* next = it->next;
+        const size_t read_end = read->last;
+        for (size_t i = read->first; i < read_end; ++i) {
+            if (w == chunk_capacity) {
+                write->last = static_cast<uint16_t>(w);
+                write = static_cast<chunk*>(write->next);
+                write->first = 0;
+                w = 0;
+            }
+            // Store unconditionally and advance only on keep: no unpredictable
+            // branch in the loop body, and the store never passes the read slot.
+            const int current = read->values[i];
+            write->values[w] = current;
+            const size_t step = keep(current) ? 1 : 0;
+            w += step;
+            kept += step;
+        }
+        it = next;
+    }
+
+    if (kept == 0) {
+        clear();
+        return;
+    }
+    if (w == write->first) {
+        // Moved on to a chunk that received nothing; the previous one is full.
+        write = static_cast<chunk*>(write->prev);
+        w = write->last;
+    }
+    truncate_after(write, w);
+    size_ = kept;
+}
+
+}  // namespace task
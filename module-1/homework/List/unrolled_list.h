@@ -0,0 +1,101 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+#include "node_pool.h"
+
+
+namespace task {
+
+
+// Same interface as list, but every node is a 128-byte chunk holding up to
+// chunk_capacity consecutive ints. Walks touch one cache line pair per
+// chunk_capacity elements instead of one per element, and remove/unique
+// compact the values in a single streaming pass.
+class unrolled_list {
+
+public:
+
+    unrolled_list();
+    unrolled_list(size_t count, const int& value = int());
+    unrolled_list(const unrolled_list& other);
+    unrolled_list(unrolled_list&& other) noexcept;
+
+    ~unrolled_list();
+    unrolled_list& operator=(const unrolled_list& other);
+    unrolled_list& operator=(unrolled_list&& other) noexcept;
+
+
+    int& front();
+    const int& front() const;
+
+    int& back();
+    const int& back() const;
+
+
+    bool empty() const;
+    size_t size() const;
+    void clear();
+
+
+    void push_back(const int& value);
+    void pop_back();
+    void push_front(const int& value);
+    void pop_front();
+    void resize(size_t count);
+    void swap(unrolled_list& other);
+
+
+    void remove(const int& value);
+    void unique();
+    void sort();
+
+
+    // Calls f(value) for every element, front to back.
+    template <class F>
+    void for_each(F&& f) const {
+        for (const chunk_base* it = head_.next; it != &head_; it = it->next) {
+            const chunk* c = static_cast<const chunk*>(it);
+            for (size_t i = c->first; i < c->last; ++i) {
+                f(c->values[i]);
+            }
+        }
+    }
+
+private:
+
+    struct chunk_base {
+        chunk_base* prev;
+        chunk_base* next;
+    };
+
+    static constexpr size_t chunk_bytes = 128;
+    static constexpr size_t chunk_capacity =
+        (chunk_bytes - sizeof(chunk_base) - 2 * sizeof(uint16_t)) / sizeof(int);
+
+    // Values live in values[first, last); free room may be on either side.
+    struct chunk : chunk_base {
+        uint16_t first;
+        uint16_t last;
+        int values[chunk_capacity];
+    };
+
+    static_assert(sizeof(chunk) == chunk_bytes, "chunk must fill exactly two cache lines");
+
+
+    chunk* create_chunk(chunk_base* pos, size_t offset);
+    void destroy_chunk(chunk_base* c);
+    void truncate_after(chunk* c, size_t last);
+    void reset_head();
+
+    template <class Keep>
+    void compact(Keep keep);
+
+
+    chunk_base head_;
+    size_t size_;
+    node_pool<chunk> pool_;
+
+};
+
+}  // namespace task
@@ -0,0 +1,96 @@
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <optional>
+#include <random>
+#include <vector>
+
+#include "optional.h"
+
+// Handles, with the largest value spare for an empty Optional.
+enum class Handle : std::uint32_t {};
+
+template <>
+struct task::OptionalNiche<Handle> : task::SentinelNiche<Handle, Handle(UINT32_MAX)> {};
+
+// The same, without the niche.
+enum class PlainHandle : std::uint32_t {};
+
+namespace {
+
+constexpr std::size_t kElements = 1 << 22;
+constexpr int kPasses = 20;
+
+template <typename F>
+double MeasureMs(F&& body) {
+    auto start = std::chrono::steady_clock::now();
+    body();
+    auto finish = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::milli>(finish - start).count();
+}
+
+std::uint64_t ValueOf(const int* p) {
+    return static_cast<std::uint64_t>(*p);
+}
+
+template <typename E>
+std::uint64_t ValueOf(E handle) {
+    return static_cast<std::uint64_t>(handle);
+}
+
+template <typename T>
+bool Engaged(const std::optional<T>& opt) {
+    return opt.has_value();
+}
+
+template <typename T>
+bool Engaged(const task::Optional<T>& opt) {
+    return opt.HasValue();
+}
+
+// kPasses scans of kElements optionals, every other one engaged at random,
+// summing the values that are there; make(i) gives the i-th value.
+template <typename Opt, typename Make>
+void ReportScan(const char* name, Make make) {
+    std::vector<Opt> opts(kElements);
+    std::mt19937 random(7);
+    for (std::size_t i = 0; i < kElements; ++i) {
+        if (random() % 2 == 0) {
+            opts[i] = make(i);
+        }
+    }
+    std::uint64_t sum = 0;
+    const double ms = MeasureMs([&] {
+        for (int pass = 0; pass < kPasses; ++pass) {
+            for (const Opt& opt : opts) {
+                if (Engaged(opt)) {
+                    sum += ValueOf(*opt);
+                }
+            }
+        }
+    });
+    volatile std::uint64_t sink = sum;
+    (void)sink;
+    std::printf("%-36s %10zu %10.2f %10.3f\n", name, sizeof(Opt), ms,
+                ms * 1e6 / (static_cast<double>(kElements) * kPasses));
+}
+
+}  // namespace
+
+int main() {
+    std::vector<int> ints(kElements, 1);
+    std::printf("%d scans of %zu optionals, half of them engaged\n", kPasses, kElements);
+    std::printf("%-36s %10s %10s %10s\n", "", "bytes", "ms", "ns each");
+    ReportScan<std::optional<const int*>>("std::optional<const int*>",
+                                          [&ints](std::size_t i) { return &ints[i]; });
+    ReportScan<task::Optional<const int*>>("task::Optional<const int*>, niche",
+                                           [&ints](std::size_t i) { return &ints[i]; });
+    ReportScan<std::optional<Handle>>("std::optional<Handle>",
+                                      [](std::size_t i) { return Handle(i); });
+    ReportScan<task::Optional<PlainHandle>>("task::Optional<PlainHandle>, flag",
+                                            [](std::size_t i) { return PlainHandle(i); });
+    ReportScan<task::Optional<Handle>>("task::Optional<Handle>, niche",
+                                       [](std::size_t i) { return Handle(i); });
+    return 0;
+}
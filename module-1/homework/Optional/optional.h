@@ -1,64 +1,429 @@
+#include <cstddef>
 #include <cstdlib>
+#include <memory>
+#include <new>
 #include <type_traits>
+#include <utility>
 
 #pragma once
 
 namespace task {
 
 struct NullOpt {
-    // Your code goes here;
+    explicit constexpr NullOpt(int) noexcept {
+    }
 };
 
-constexpr NullOpt kNullOpt = // Your code goes here;
+constexpr NullOpt kNullOpt = NullOpt(0);
 
 struct InPlace {
-    // Your code goes here;
+    explicit InPlace() = default;
 };
 
-constexpr InPlace kInPlace =  //Your code goes here;
+constexpr InPlace kInPlace = InPlace();
+
+// OptionalNiche
+// Lets Optional<T> keep its empty state inside the T itself, with no engaged
+// flag next to it, so that sizeof(Optional<T>) == sizeof(T). A
+// specialization names a sentinel, a value that T's users never store:
+//
+//     static T Empty() noexcept;                     // the sentinel
+//     static bool IsEmpty(const T& value) noexcept;  // whether value is it
+//
+// Storing a value for which IsEmpty holds leaves the Optional empty. Object
+// pointers have a niche already; enumerations and other types with a spare
+// value get one from SentinelNiche:
+//
+//     template <>
+//     struct task::OptionalNiche<Color> : task::SentinelNiche<Color, Color(-1)> {};
+template <typename T, typename = void>
+struct OptionalNiche {};
+
+template <typename T, T kSentinel>
+struct SentinelNiche {
+    static constexpr T Empty() noexcept {
+        return kSentinel;
+    }
+
+    static constexpr bool IsEmpty(const T& value) noexcept {
+        return value == kSentinel;
+    }
+};
+
+namespace detail {
+
+// Only the addresses of these are used: no object of any other type lives
+// there, so a pointer to one is free to mean "empty", and nullptr stays a
+// value. A pointer to a scalar or to void gets a slot of its own type, whose
+// address is a constant expression. Any other pointee, possibly incomplete,
+// shares one byte aligned for every type that is not over-aligned; those
+// Optional<T*> are not usable in constant expressions, and over-aligned T is
+// not supported.
+template <typename T>
+inline constexpr T kPointerNicheSlot{};
+
+alignas(std::max_align_t) inline constexpr unsigned char kPointerNiche = 0;
+
+}  // namespace detail
+
+template <typename T>
+struct OptionalNiche<T*, std::enable_if_t<std::is_object_v<T> || std::is_void_v<T>>> {
+    static constexpr T* Empty() noexcept {
+        if constexpr (std::is_scalar_v<T>) {
+            using Slot = std::remove_cv_t<T>;
+            return const_cast<Slot*>(&detail::kPointerNicheSlot<Slot>);
+        } else if constexpr (std::is_void_v<T>) {
+            return const_cast<unsigned char*>(&detail::kPointerNicheSlot<unsigned char>);
+        } else {
+            const void* niche = &detail::kPointerNiche;
+            return static_cast<T*>(const_cast<void*>(niche));
+        }
+    }
+
+    static constexpr bool IsEmpty(T* value) noexcept {
+        return value == Empty();
+    }
+};
+// OptionalNiche
+
+namespace detail {
+
+template <typename T, typename = void>
+struct HasOptionalNiche : std::false_type {};
+
+template <typename T>
+struct HasOptionalNiche<T, std::void_t<decltype(OptionalNiche<T>::Empty())>> : std::true_type {};
+
+// Storage for types with a niche: value_ always holds a T, the sentinel
+// while the Optional is empty, and copies along with it.
+template <typename T>
+class OptionalNicheStorage {
+protected:
+    using Niche = OptionalNiche<T>;
+
+    constexpr OptionalNicheStorage() noexcept : value_(Niche::Empty()) {
+    }
+
+    template <typename... Args>
+    constexpr explicit OptionalNicheStorage(InPlace, Args&&... args)
+        : value_(std::forward<Args>(args)...) {
+    }
+
+    constexpr bool Engaged() const noexcept {
+        return !Niche::IsEmpty(value_);
+    }
+
+    constexpr T& Value() noexcept {
+        return value_;
+    }
+
+    constexpr const T& Value() const noexcept {
+        return value_;
+    }
+
+    template <typename... Args>
+    void Construct(Args&&... args) {
+        value_ = T(std::forward<Args>(args)...);
+    }
+
+    void Destroy() noexcept {
+        value_ = Niche::Empty();
+    }
+
+    T value_;
+};
+
+// Storage with an engaged flag. Trivially copyable types keep the
+// defaulted, trivial copies and destructor.
+template <typename T, bool = std::is_trivially_copyable_v<T>>
+class OptionalFlagStorage {
+protected:
+    constexpr OptionalFlagStorage() noexcept : empty_() {
+    }
+
+    template <typename... Args>
+    constexpr explicit OptionalFlagStorage(InPlace, Args&&... args)
+        : value_(std::forward<Args>(args)...), engaged_(true) {
+    }
+
+    constexpr bool Engaged() const noexcept {
+        return engaged_;
+    }
+
+    // The value is made with placement new, so it is read through launder;
+    // that also keeps GCC from warning that it may be uninitialised.
+    constexpr T& Value() noexcept {
+        return *std::launder(std::addressof(value_));
+    }
+
+    constexpr const T& Value() const noexcept {
+        return *std::launder(std::addressof(value_));
+    }
+
+    template <typename... Args>
+    void Construct(Args&&... args) {
+        ::new (static_cast<void*>(std::addressof(value_))) T(std::forward<Args>(args)...);
+        engaged_ = true;
+    }
+
+    void Destroy() noexcept {
+        engaged_ = false;
+    }
+
+    union {
+        char empty_;
+        T value_;
+    };
+    bool engaged_ = false;
+};
 
 template <typename T>
-class Optional : public // Your code goes here; {
+class OptionalFlagStorage<T, false> {
+public:
+    OptionalFlagStorage(const OptionalFlagStorage& other) : empty_() {
+        if (other.engaged_) {
+            Construct(other.value_);
+        }
+    }
+
+    OptionalFlagStorage(OptionalFlagStorage&& other) noexcept(
+        std::is_nothrow_move_constructible_v<T>)
+        : empty_() {
+        if (other.engaged_) {
+            Construct(std::move(other.value_));
+        }
+    }
+
+    OptionalFlagStorage& operator=(const OptionalFlagStorage& other) {
+        Assign(other.engaged_, other.value_);
+        return *this;
+    }
+
+    OptionalFlagStorage& operator=(OptionalFlagStorage&& other) noexcept(
+        std::is_nothrow_move_constructible_v<T> && std::is_nothrow_move_assignable_v<T>) {
+        Assign(other.engaged_, std::move(other.value_));
+        return *this;
+    }
+
+    ~OptionalFlagStorage() {
+        Destroy();
+    }
+
+protected:
+    OptionalFlagStorage() noexcept : empty_() {
+    }
+
+    template <typename... Args>
+    explicit OptionalFlagStorage(InPlace, Args&&... args)
+        : value_(std::forward<Args>(args)...), engaged_(true) {
+    }
+
+    bool Engaged() const noexcept {
+        return engaged_;
+    }
+
+    T& Value() noexcept {
+        return *std::launder(std::addressof(value_));
+    }
+
+    const T& Value() const noexcept {
+        return *std::launder(std::addressof(value_));
+    }
+
+    template <typename... Args>
+    void Construct(Args&&... args) {
+        ::new (static_cast<void*>(std::addressof(value_))) T(std::forward<Args>(args)...);
+        engaged_ = true;
+    }
+
+    void Destroy() noexcept {
+        if (engaged_) {
+            value_.~T();
+            engaged_ = false;
+        }
+    }
+
+    union {
+        char empty_;
+        T value_;
+    };
+    bool engaged_ = false;
+
+private:
+    // Takes over the state of another storage: engaged with value, or not.
+    template <typename U>
+    void Assign(bool engaged, U&& value) {
+        if (!engaged) {
+            Destroy();
+        } else if (engaged_) {
+            value_ = std::forward<U>(value);
+        } else {
+            Construct(std::forward<U>(value));
+        }
+    }
+};
+
+template <typename T>
+using OptionalStorage = std::conditional_t<HasOptionalNiche<T>::value, OptionalNicheStorage<T>,
+                                           OptionalFlagStorage<T>>;
+
+// Empty bases that delete one copy or move operation of Optional<T> when T
+// lacks what it needs, as std::optional does, so that the traits tell the
+// truth instead of the storage failing to compile.
+template <bool kEnable>
+struct CopyConstructGuard {};
+
+template <>
+struct CopyConstructGuard<false> {
+    CopyConstructGuard() = default;
+    CopyConstructGuard(const CopyConstructGuard&) = delete;
+    CopyConstructGuard(CopyConstructGuard&&) = default;
+    CopyConstructGuard& operator=(const CopyConstructGuard&) = default;
+    CopyConstructGuard& operator=(CopyConstructGuard&&) = default;
+};
+
+template <bool kEnable>
+struct MoveConstructGuard {};
+
+template <>
+struct MoveConstructGuard<false> {
+    MoveConstructGuard() = default;
+    MoveConstructGuard(const MoveConstructGuard&) = default;
+    MoveConstructGuard(MoveConstructGuard&&) = delete;
+    MoveConstructGuard& operator=(const MoveConstructGuard&) = default;
+    MoveConstructGuard& operator=(MoveConstructGuard&&) = default;
+};
+
+template <bool kEnable>
+struct CopyAssignGuard {};
+
+template <>
+struct CopyAssignGuard<false> {
+    CopyAssignGuard() = default;
+    CopyAssignGuard(const CopyAssignGuard&) = default;
+    CopyAssignGuard(CopyAssignGuard&&) = default;
+    CopyAssignGuard& operator=(const CopyAssignGuard&) = delete;
+    CopyAssignGuard& operator=(CopyAssignGuard&&) = default;
+};
+
+template <bool kEnable>
+struct MoveAssignGuard {};
+
+template <>
+struct MoveAssignGuard<false> {
+    MoveAssignGuard() = default;
+    MoveAssignGuard(const MoveAssignGuard&) = default;
+    MoveAssignGuard(MoveAssignGuard&&) = default;
+    MoveAssignGuard& operator=(const MoveAssignGuard&) = default;
+    MoveAssignGuard& operator=(MoveAssignGuard&&) = delete;
+};
+
+// Whether Optional<T> may be built from, or assigned, a U.
+template <typename T, typename U>
+constexpr bool kOptionalAccepts =
+    std::is_constructible_v<T, U&&> &&
+    !std::is_same_v<std::decay_t<U>, NullOpt> && !std::is_same_v<std::decay_t<U>, InPlace>;
+
+}  // namespace detail
+
+template <typename T>
+class Optional
+    : public detail::OptionalStorage<T>,
+      private detail::CopyConstructGuard<std::is_copy_constructible_v<T>>,
+      private detail::MoveConstructGuard<std::is_move_constructible_v<T>>,
+      private detail::CopyAssignGuard<std::is_copy_constructible_v<T> &&
+                                      std::is_copy_assignable_v<T>>,
+      private detail::MoveAssignGuard<std::is_move_constructible_v<T> &&
+                                      std::is_move_assignable_v<T>> {
+    using Base = detail::OptionalStorage<T>;
+
 public:
-    using value_type =  // Your code goes here;
+    using value_type = T;
 
-    constexpr Optional() noexcept;
+    constexpr Optional() noexcept : Base() {
+    }
 
-    template <typename U = value_type>
-    constexpr explicit Optional(U&& value);
+    template <typename U = value_type,
+              typename = std::enable_if_t<detail::kOptionalAccepts<T, U> &&
+                                          !std::is_same_v<std::decay_t<U>, Optional>>>
+    constexpr explicit Optional(U&& value) : Base(kInPlace, std::forward<U>(value)) {
+    }
 
-    constexpr explicit Optional(NullOpt) noexcept;
+    constexpr explicit Optional(NullOpt) noexcept : Base() {
+    }
 
     template <typename... Args>
-    constexpr explicit Optional(InPlace, Args&&... args);
+    constexpr explicit Optional(InPlace, Args&&... args)
+        : Base(kInPlace, std::forward<Args>(args)...) {
+    }
 
-    Optional& operator=(NullOpt) noexcept;
+    Optional& operator=(NullOpt) noexcept {
+        Reset();
+        return *this;
+    }
 
-    template <typename U = T>
-    Optional& operator=(U&& value);
+    template <typename U = T,
+              typename = std::enable_if_t<detail::kOptionalAccepts<T, U> &&
+                                          !std::is_same_v<std::decay_t<U>, Optional>>>
+    Optional& operator=(U&& value) {
+        if (HasValue()) {
+            this->Value() = std::forward<U>(value);
+        } else {
+            this->Construct(std::forward<U>(value));
+        }
+        return *this;
+    }
 
-    void Reset() noexcept;
+    void Reset() noexcept {
+        this->Destroy();
+    }
 
     template <typename U>
-    constexpr T ValueOr(U&& default_value) const&;
+    constexpr T ValueOr(U&& default_value) const& {
+        if (HasValue()) {
+            return this->Value();
+        }
+        return static_cast<T>(std::forward<U>(default_value));
+    }
 
     template <typename U>
-    constexpr T ValueOr(U&& default_value) &&;
+    constexpr T ValueOr(U&& default_value) && {
+        if (HasValue()) {
+            return std::move(this->Value());
+        }
+        return static_cast<T>(std::forward<U>(default_value));
+    }
 
-    constexpr bool HasValue() const noexcept;
+    constexpr bool HasValue() const noexcept {
+        return this->Engaged();
+    }
 
-    constexpr explicit operator bool() const noexcept;
+    constexpr explicit operator bool() const noexcept {
+        return HasValue();
+    }
 
-    constexpr std::add_pointer_t<const value_type> operator->() const;
+    constexpr std::add_pointer_t<const value_type> operator->() const {
+        return std::addressof(this->Value());
+    }
 
-    constexpr std::add_pointer_t<value_type> operator->();
+    constexpr std::add_pointer_t<value_type> operator->() {
+        return std::addressof(this->Value());
+    }
 
-    constexpr const value_type& operator*() const&;
+    constexpr const value_type& operator*() const& {
+        return this->Value();
+    }
 
-    constexpr value_type& operator*() &;
+    constexpr value_type& operator*() & {
+        return this->Value();
+    }
 
-    constexpr const value_type&& operator*() const&&;
+    constexpr const value_type&& operator*() const&& {
+        return std::move(this->Value());
+    }
 
-    constexpr value_type&& operator*() &&;
+    constexpr value_type&& operator*() && {
+        return std::move(this->Value());
+    }
 };
-}  // namespace task
\ No newline at end of file
+}  // namespace task
@@ -1,5 +1,8 @@
 #include <cstdint>
+#include <memory>
 #include <string>
+#include <type_traits>
+#include <vector>
 
 #include "gtest/gtest.h"
 #include "optional.h"
@@ -40,6 +43,120 @@ TEST(IndirectionOperator, Test1) {
     ASSERT_EQ(*opt, 1);
 }
 
+// OptionalNiche
+enum class Color : std::uint8_t { kRed, kGreen, kBlue };
+
+template <>
+struct task::OptionalNiche<Color> : task::SentinelNiche<Color, Color(0xff)> {};
+
+static_assert(sizeof(task::Optional<int*>) == sizeof(int*));
+static_assert(sizeof(task::Optional<const char*>) == sizeof(const char*));
+static_assert(sizeof(task::Optional<void*>) == sizeof(void*));
+static_assert(sizeof(task::Optional<Color>) == sizeof(Color));
+static_assert(sizeof(task::Optional<int32_t>) > sizeof(int32_t));
+static_assert(std::is_trivially_copyable_v<task::Optional<int*>>);
+static_assert(std::is_trivially_copyable_v<task::Optional<int32_t>>);
+static_assert(!std::is_copy_constructible_v<task::Optional<std::unique_ptr<int>>>);
+static_assert(!std::is_copy_assignable_v<task::Optional<std::unique_ptr<int>>>);
+static_assert(std::is_nothrow_move_constructible_v<task::Optional<std::unique_ptr<int>>>);
+static_assert(std::is_nothrow_move_assignable_v<task::Optional<std::unique_ptr<int>>>);
+static_assert(std::is_copy_constructible_v<task::Optional<const std::string>>);
+static_assert(!std::is_copy_assignable_v<task::Optional<const std::string>>);
+
+constexpr task::Optional<int32_t> kFive(5);
+static_assert(kFive.HasValue());
+static_assert(*kFive == 5);
+static_assert(kFive.ValueOr(0) == 5);
+constexpr task::Optional<Color> kNoColor;
+static_assert(!kNoColor);
+static_assert(kNoColor.ValueOr(Color::kRed) == Color::kRed);
+
+// An engaged nullptr is left to the tests below: with -fsanitize=null, GCC
+// will not fold a comparison of nullptr with the address of an inline variable.
+constexpr int kAnswer = 42;
+constexpr task::Optional<int*> kNoPointer;
+constexpr task::Optional<const int*> kAnswerPointer(&kAnswer);
+constexpr task::Optional<const void*> kNoAddress;
+static_assert(!kNoPointer);
+static_assert(kNoPointer.ValueOr(nullptr) == nullptr);
+static_assert(kAnswerPointer);
+static_assert(**kAnswerPointer == 42);
+static_assert(!kNoAddress);
+
+TEST(Niche, PointerMayHoldNull) {
+    int value = 5;
+    task::Optional<int*> opt;
+    ASSERT_FALSE(opt.HasValue());
+    opt = nullptr;
+    ASSERT_TRUE(opt.HasValue());
+    ASSERT_EQ(*opt, nullptr);
+    opt = &value;
+    ASSERT_EQ(**opt, 5);
+    ASSERT_EQ(opt.ValueOr(nullptr), &value);
+    opt = task::kNullOpt;
+    ASSERT_FALSE(opt);
+    ASSERT_EQ(opt.ValueOr(nullptr), nullptr);
+}
+
+struct Opaque;
+
+TEST(Niche, PointerToClass) {
+    std::string text = "text";
+    task::Optional<std::string*> opt;
+    ASSERT_FALSE(opt.HasValue());
+    opt = &text;
+    ASSERT_TRUE(opt);
+    ASSERT_EQ((*opt)->size(), 4u);
+    task::Optional<Opaque*> opaque;
+    ASSERT_FALSE(opaque.HasValue());
+    opaque = nullptr;
+    ASSERT_TRUE(opaque);
+    ASSERT_EQ(*opaque, nullptr);
+}
+
+TEST(Niche, Enum) {
+    std::vector<task::Optional<Color>> colors(3);
+    colors[1] = Color::kGreen;
+    colors[2] = task::Optional<Color>(Color::kRed);
+    ASSERT_FALSE(colors[0]);
+    ASSERT_EQ(*colors[1], Color::kGreen);
+    ASSERT_TRUE(colors[2].HasValue());
+    colors[1].Reset();
+    ASSERT_EQ(colors[1].ValueOr(Color::kBlue), Color::kBlue);
+}
+
+TEST(Flag, CopiesAndDestroysValue) {
+    auto shared = std::make_shared<int>(1);
+    {
+        task::Optional<std::shared_ptr<int>> opt(shared);
+        task::Optional<std::shared_ptr<int>> copy = opt;
+        task::Optional<std::shared_ptr<int>> empty;
+        ASSERT_EQ(shared.use_count(), 3);
+        copy = empty;
+        ASSERT_FALSE(copy);
+        ASSERT_EQ(shared.use_count(), 2);
+        empty = std::move(opt);
+        ASSERT_TRUE(empty);
+        ASSERT_EQ(shared.use_count(), 2);
+    }
+    ASSERT_EQ(shared.use_count(), 1);
+}
+
+TEST(Flag, MovesMoveOnlyValue) {
+    task::Optional<std::unique_ptr<int>> opt(std::make_unique<int>(7));
+    task::Optional<std::unique_ptr<int>> moved = std::move(opt);
+    ASSERT_TRUE(moved);
+    ASSERT_EQ(**moved, 7);
+    opt = std::move(moved);
+    ASSERT_TRUE(opt);
+    ASSERT_EQ(**opt, 7);
+}
+
+TEST(InPlace, Test1) {
+    task::Optional<std::string> opt(task::kInPlace, 3, 'x');
+    ASSERT_EQ(*opt, "xxx");
+}
+
 int main(int argc, char** argv) {
     ::testing::InitGoogleTest(&argc, argv);
     return RUN_ALL_TESTS();
@@ -0,0 +1,477 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdio>
+#include <cstdint>
+#include <cstdlib>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <numeric>
+#include <random>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "../Allocator/src/allocator/allocator.h"
+#include "src/shared_ptr/atomic_shared_ptr.h"
+#include "src/shared_ptr/intrusive_ptr.h"
+#include "src/shared_ptr/release_batch.h"
+#include "src/shared_ptr/shared_ptr.h"
+#include "src/shared_ptr/weak_value_cache.h"
+
+namespace {
+
+constexpr std::size_t kOperations = 10'000'000;
+
+// Calls to the global operator new.
+std::atomic<std::size_t> heap_allocations{0};
+
+}  // namespace
+
+// Kept out of line so that GCC does not see malloc and free meet a new
+// expression and a delete expression and warn about a mismatch.
+[[gnu::noinline]] void* operator new(std::size_t bytes) {
+    heap_allocations.fetch_add(1, std::memory_order_relaxed);
+    if (void* p = std::malloc(bytes == 0 ? 1 : bytes)) {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+[[gnu::noinline]] void operator delete(void* p) noexcept {
+    std::free(p);
+}
+
+[[gnu::noinline]] void operator delete(void* p, std::size_t) noexcept {
+    std::free(p);
+}
+
+namespace {
+
+template <typename F>
+double MeasureMs(F&& body) {
+    auto start = std::chrono::steady_clock::now();
+    body();
+    auto finish = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::milli>(finish - start).count();
+}
+
+// kOperations copies of one pointer, made kBatch at a time into a vector and
+// then destroyed, so every copy really touches the count.
+template <typename Ptr>
+void ReportCopies(const char* name, const Ptr& source) {
+    constexpr std::size_t kBatch = 1000;
+    std::vector<Ptr> copies;
+    copies.reserve(kBatch);
+    const double ms = MeasureMs([&] {
+        for (std::size_t done = 0; done < kOperations; done += kBatch) {
+            for (std::size_t i = 0; i < kBatch; ++i) {
+                copies.push_back(source);
+            }
+            copies.clear();
+        }
+    });
+    std::printf("%-36s %10.2f %10.2f\n", name, ms, ms * 1e6 / kOperations);
+}
+
+// A payload the size of a few fields, so the object is not free to create.
+struct Widget {
+    explicit Widget(int value) : values{value, value, value, value} {
+    }
+
+    int values[4];
+};
+
+// kOperations pointers created with make and destroyed right away; make
+// returns the new pointer. Reports heap allocations per pointer.
+template <typename Make>
+void ReportCreation(const char* name, Make make) {
+    const std::size_t allocations = heap_allocations;
+    int sum = 0;
+    const double ms = MeasureMs([&] {
+        for (std::size_t i = 0; i < kOperations; ++i) {
+            auto ptr = make(static_cast<int>(i));
+            sum += ptr->values[0];
+        }
+    });
+    volatile int sink = sum;
+    (void)sink;
+    std::printf("%-36s %10.2f %10.2f %10.2f\n", name, ms, ms * 1e6 / kOperations,
+                static_cast<double>(heap_allocations - allocations) / kOperations);
+}
+
+// kOperations pointers made by make(i) and destroyed right away, where make
+// returns a pointer to a char; reports heap allocations per pointer.
+template <typename Make>
+void ReportBuffers(const char* name, Make make) {
+    const std::size_t allocations = heap_allocations;
+    int sum = 0;
+    const double ms = MeasureMs([&] {
+        for (std::size_t i = 0; i < kOperations; ++i) {
+            auto ptr = make(i);
+            sum += ptr.Get()[0];
+        }
+    });
+    volatile int sink = sum;
+    (void)sink;
+    std::printf("%-36s %10.2f %10.2f %10.2f\n", name, ms, ms * 1e6 / kOperations,
+                static_cast<double>(heap_allocations - allocations) / kOperations);
+}
+
+// The usual way to publish a SharedPtr.
+template <typename T>
+class LockedSharedPtr {
+public:
+    explicit LockedSharedPtr(SharedPtr<T> value) : value_(std::move(value)) {
+    }
+
+    SharedPtr<T> Load() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return value_;
+    }
+
+    void Store(SharedPtr<T> value) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        value_.Swap(value);
+    }
+
+private:
+    mutable std::mutex mutex_;
+    SharedPtr<T> value_;
+};
+
+// reader_count threads load the published snapshot kOperations times in
+// total and read from it, while one writer keeps publishing new ones until
+// they are done. Returns the readers' wall time.
+template <typename Published>
+double ReadMostly(std::size_t reader_count) {
+    Published published(MakeShared<Widget>(0));
+    std::atomic<bool> done{false};
+    std::atomic<int> sum{0};
+    std::thread writer([&] {
+        for (int i = 1; !done.load(std::memory_order_relaxed); ++i) {
+            published.Store(MakeShared<Widget>(i));
+            std::this_thread::yield();
+        }
+    });
+    const std::size_t per_reader = kOperations / reader_count;
+    const double ms = MeasureMs([&] {
+        std::vector<std::thread> readers;
+        for (std::size_t r = 0; r < reader_count; ++r) {
+            readers.emplace_back([&] {
+                int local = 0;
+                for (std::size_t i = 0; i < per_reader; ++i) {
+                    local += published.Load()->values[0];
+                }
+                sum += local;
+            });
+        }
+        for (std::thread& reader : readers) {
+            reader.join();
+        }
+    });
+    done = true;
+    writer.join();
+    return ms;
+}
+
+void ReportReadMostly(std::size_t reader_count) {
+    std::printf("%-36zu %10.2f %10.2f\n", reader_count,
+                ReadMostly<LockedSharedPtr<Widget>>(reader_count),
+                ReadMostly<AtomicSharedPtr<Widget>>(reader_count));
+}
+
+// thread_count threads share one pointer. Each fills a vector with copies of
+// it kBatch at a time and clears it, kOperations copies in total, with the
+// vector's destructors or with a SharedPtrReleaseBatch.
+template <bool kBatched>
+double ClearCopies(std::size_t thread_count) {
+    constexpr std::size_t kBatch = 1000;
+    const SharedPtr<Widget> shared = MakeShared<Widget>(0);
+    const std::size_t per_thread = kOperations / thread_count;
+    return MeasureMs([&] {
+        std::vector<std::thread> threads;
+        for (std::size_t t = 0; t < thread_count; ++t) {
+            threads.emplace_back([&shared, per_thread] {
+                std::vector<SharedPtr<Widget>> copies(kBatch);
+                SharedPtrReleaseBatch<> batch;
+                for (std::size_t done = 0; done < per_thread; done += kBatch) {
+                    std::fill(copies.begin(), copies.end(), shared);
+                    if (kBatched) {
+                        batch.AddRange(copies.begin(), copies.end());
+                        batch.Flush();
+                    } else {
+                        for (SharedPtr<Widget>& copy : copies) {
+                            copy.Reset();
+                        }
+                    }
+                }
+            });
+        }
+        for (std::thread& thread : threads) {
+            thread.join();
+        }
+    });
+}
+
+void ReportClearCopies(std::size_t thread_count) {
+    std::printf("%-36zu %10.2f %10.2f\n", thread_count, ClearCopies<false>(thread_count),
+                ClearCopies<true>(thread_count));
+}
+
+template <typename T>
+std::shared_ptr<T> LockOf(const std::weak_ptr<T>& weak) {
+    return weak.lock();
+}
+
+template <typename T>
+SharedPtr<T> LockOf(const WeakPtr<T>& weak) {
+    return weak.Lock();
+}
+
+// locker_count threads lock one weak pointer and drop the result,
+// kOperations times in total, while another thread holds the only strong
+// reference and drops it once half of the locks are done. Returns the
+// lockers' wall time; locked counts the locks that found the object.
+template <typename Strong, typename Weak>
+double LockWhileDropping(Strong strong, std::size_t locker_count, std::size_t& locked) {
+    constexpr std::size_t kReport = 1024;
+    const Weak weak(strong);
+    const std::size_t per_locker = kOperations / locker_count;
+    std::atomic<std::size_t> progress{0};
+    std::atomic<std::size_t> successes{0};
+    std::thread dropper([&] {
+        while (progress.load(std::memory_order_relaxed) < kOperations / 2) {
+            std::this_thread::yield();
+        }
+        strong = Strong();
+    });
+    const double ms = MeasureMs([&] {
+        std::vector<std::thread> lockers;
+        for (std::size_t l = 0; l < locker_count; ++l) {
+            lockers.emplace_back([&] {
+                std::size_t local = 0;
+                for (std::size_t i = 1; i <= per_locker; ++i) {
+                    local += static_cast<bool>(LockOf(weak));
+                    if (i % kReport == 0) {
+                        progress.fetch_add(kReport, std::memory_order_relaxed);
+                    }
+                }
+                successes += local;
+            });
+        }
+        for (std::thread& locker : lockers) {
+            locker.join();
+        }
+    });
+    // Lets the dropper go even if rounding kept progress short of half way.
+    progress = kOperations;
+    dropper.join();
+    locked = successes;
+    return ms;
+}
+
+void ReportLockWhileDropping(std::size_t locker_count) {
+    std::size_t std_locked = 0;
+    std::size_t locked = 0;
+    const double std_ms = LockWhileDropping<std::shared_ptr<Widget>, std::weak_ptr<Widget>>(
+        std::make_shared<Widget>(0), locker_count, std_locked);
+    const double ms = LockWhileDropping<SharedPtr<Widget>, WeakPtr<Widget>>(
+        MakeShared<Widget>(0), locker_count, locked);
+    std::printf("%-36zu %10.2f %10.2f %10.2f %10.2f\n", locker_count, std_ms,
+                100.0 * std_locked / kOperations, ms, 100.0 * locked / kOperations);
+}
+
+// The same cache behind one mutex, with no sweeping, to compare with.
+template <typename K, typename T>
+class LockedWeakValueCache {
+public:
+    template <typename Make>
+    SharedPtr<T> GetOrCreate(const K& key, Make make) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        WeakPtr<T>& entry = entries_[key];
+        SharedPtr<T> value = entry.Lock();
+        if (!value) {
+            value = make();
+            entry = WeakPtr<T>(value);
+        }
+        return value;
+    }
+
+private:
+    std::mutex mutex_;
+    std::unordered_map<K, WeakPtr<T>> entries_;
+};
+
+constexpr std::size_t kLookups = kOperations / 10;
+
+// thread_count threads look up kLookups random keys in total out of
+// kKeys, creating the values that are missing. Each thread keeps its last
+// kHeld results alive, so a lookup hits only if some thread still holds its
+// value. Returns the wall time and reports hits through hits.
+template <typename Cache>
+double CacheLookups(std::size_t thread_count, std::size_t& hits) {
+    constexpr std::uint32_t kKeys = 1 << 16;
+    constexpr std::size_t kHeld = 4096;
+    Cache cache;
+    std::atomic<std::size_t> created{0};
+    const std::size_t per_thread = kLookups / thread_count;
+    const double ms = MeasureMs([&] {
+        std::vector<std::thread> threads;
+        for (std::size_t t = 0; t < thread_count; ++t) {
+            threads.emplace_back([&, t] {
+                std::vector<SharedPtr<Widget>> held(kHeld);
+                std::mt19937 random(static_cast<std::uint32_t>(t));
+                std::size_t local = 0;
+                for (std::size_t i = 0; i < per_thread; ++i) {
+                    const int key = static_cast<int>(random() % kKeys);
+                    held[i % kHeld] = cache.GetOrCreate(key, [key, &local] {
+                        ++local;
+                        return MakeShared<Widget>(key);
+                    });
+                }
+                created += local;
+            });
+        }
+        for (std::thread& thread : threads) {
+            thread.join();
+        }
+    });
+    hits = per_thread * thread_count - created;
+    return ms;
+}
+
+void ReportCacheLookups(std::size_t thread_count) {
+    std::size_t locked_hits = 0;
+    std::size_t hits = 0;
+    const double locked_ms =
+        CacheLookups<LockedWeakValueCache<int, Widget>>(thread_count, locked_hits);
+    const double ms = CacheLookups<WeakValueCache<int, Widget>>(thread_count, hits);
+    std::printf("%-36zu %10.2f %10.2f %10.2f %10.2f\n", thread_count, locked_ms,
+                100.0 * locked_hits / kLookups, ms, 100.0 * hits / kLookups);
+}
+
+// A small hot object, with its count inside for IntrusivePtr.
+struct HotObject {
+    explicit HotObject(int value) : value(value) {
+    }
+
+    int value;
+};
+
+struct IntrusiveHotObject : HotObject, RefCounted<IntrusiveHotObject> {
+    using HotObject::HotObject;
+};
+
+// kObjects pointers, each to its own object, visited in random order: every
+// step copies the pointer and reads through the copy, so a pointer whose
+// count lives apart from the object pays for two cache lines.
+template <typename Ptr, typename Make>
+void ReportCopyAndRead(const char* name, Make make) {
+    constexpr std::size_t kObjects = 1 << 20;
+    constexpr int kPasses = 5;
+    std::vector<Ptr> ptrs;
+    ptrs.reserve(kObjects);
+    for (std::size_t i = 0; i < kObjects; ++i) {
+        ptrs.push_back(make(static_cast<int>(i)));
+    }
+    std::vector<std::uint32_t> order(kObjects);
+    std::iota(order.begin(), order.end(), 0);
+    std::shuffle(order.begin(), order.end(), std::mt19937(7));
+
+    long long sum = 0;
+    const double ms = MeasureMs([&] {
+        for (int pass = 0; pass < kPasses; ++pass) {
+            for (std::uint32_t index : order) {
+                Ptr copy = ptrs[index];
+                sum += copy->value;
+            }
+        }
+    });
+    volatile long long sink = sum;
+    (void)sink;
+    std::printf("%-36s %10.2f\n", name, ms * 1e6 / (kObjects * kPasses));
+}
+
+}  // namespace
+
+int main() {
+    std::printf("%zu copies and destructions of one pointer\n", kOperations);
+    std::printf("%-36s %10s %10s\n", "", "ms", "ns each");
+    ReportCopies("std::shared_ptr", std::make_shared<int>(0));
+    ReportCopies("SharedPtr, AtomicPolicy", MakeShared<int, AtomicPolicy>(0));
+    ReportCopies("SharedPtr, SingleThreadPolicy", MakeShared<int, SingleThreadPolicy>(0));
+
+    std::printf("\n%zu pointers to a new object, each destroyed right away\n", kOperations);
+    std::printf("%-36s %10s %10s %10s\n", "", "ms", "ns each", "new calls");
+    ReportCreation("std::make_shared",
+                   [](int value) { return std::make_shared<Widget>(value); });
+    ReportCreation("SharedPtr(new T)",
+                   [](int value) { return SharedPtr<Widget>(new Widget(value)); });
+    ReportCreation("MakeShared", [](int value) { return MakeShared<Widget>(value); });
+    CustomAllocator<Widget> custom_alloc;
+    ReportCreation("std::allocate_shared, CustomAllocator", [&custom_alloc](int value) {
+        return std::allocate_shared<Widget>(custom_alloc, value);
+    });
+    ReportCreation("AllocateShared, CustomAllocator", [&custom_alloc](int value) {
+        return AllocateShared<Widget>(custom_alloc, value);
+    });
+
+    std::printf("\n%zu views of a shared buffer, or small arrays\n", kOperations);
+    std::printf("%-36s %10s %10s %10s\n", "", "ms", "ns each", "new calls");
+    constexpr std::size_t kBufferSize = 1 << 16;
+    const SharedPtr<char[]> buffer = MakeShared<char[]>(kBufferSize);
+    ReportBuffers("view with its own control block", [&buffer](std::size_t i) {
+        return SharedPtr<char>(buffer.Get() + i % kBufferSize, [buffer](char*) {});
+    });
+    ReportBuffers("view by aliasing", [&buffer](std::size_t i) {
+        return SharedPtr<char[]>(buffer, buffer.Get() + i % kBufferSize);
+    });
+    ReportBuffers("SharedPtr<char[]>(new char[64])",
+                  [](std::size_t) { return SharedPtr<char[]>(new char[64]()); });
+    ReportBuffers("MakeShared<char[]>(64)", [](std::size_t) { return MakeShared<char[]>(64); });
+
+    std::printf("\n%zu loads of a snapshot one writer keeps replacing\n", kOperations);
+    std::printf("%-36s %10s %10s\n", "readers", "mutex ms", "atomic ms");
+    for (std::size_t readers = 1; readers <= 16; readers *= 2) {
+        ReportReadMostly(readers);
+    }
+
+    std::printf("\n%zu copies of one pointer made and dropped across threads\n", kOperations);
+    std::printf("%-36s %10s %10s\n", "threads", "one by one", "batched");
+    for (std::size_t threads = 1; threads <= 16; threads *= 2) {
+        ReportClearCopies(threads);
+    }
+
+    std::printf("\n%zu locks of a weak pointer whose object goes half way\n", kOperations);
+    std::printf("%-36s %10s %10s %10s %10s\n", "lockers", "std ms", "std % hit", "ms",
+                "% hit");
+    for (std::size_t lockers = 1; lockers <= 16; lockers *= 2) {
+        ReportLockWhileDropping(lockers);
+    }
+
+    std::printf("\n%zu cache lookups of random keys, values made on a miss\n", kLookups);
+    std::printf("%-36s %10s %10s %10s %10s\n", "threads", "locked ms", "% hit", "sharded ms",
+                "% hit");
+    for (std::size_t threads = 1; threads <= 16; threads *= 2) {
+        ReportCacheLookups(threads);
+    }
+
+    std::printf("\n%d pointers copied and read through in random order\n", 1 << 20);
+    std::printf("%-36s %10s\n", "", "ns each");
+    // Objects made before their owners, so objects and control blocks lie
+    // apart, as they do when a pointer takes over an existing object.
+    std::vector<HotObject*> objects;
+    for (int i = 0; i < 1 << 20; ++i) {
+        objects.push_back(new HotObject(i));
+    }
+    ReportCopyAndRead<SharedPtr<HotObject>>(
+        "SharedPtr(new T)", [&objects](int i) { return SharedPtr<HotObject>(objects[i]); });
+    ReportCopyAndRead<SharedPtr<HotObject>>(
+        "MakeShared", [](int value) { return MakeShared<HotObject>(value); });
+    ReportCopyAndRead<IntrusivePtr<IntrusiveHotObject>>(
+        "IntrusivePtr", [](int value) { return MakeIntrusive<IntrusiveHotObject>(value); });
+    return 0;
+}
@@ -1,28 +1,310 @@
 #pragma once
 
 #include <atomic>
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
 
+// Lock policies say how the reference counts of a control block change.
+// AtomicPolicy makes SharedPtr and WeakPtr safe to copy and destroy from
+// several threads at once. Taking a reference only needs the count to go up,
+// so it is relaxed; dropping one is acq_rel, so that whatever the other
+// owners did with the object happens before the last one destroys it.
+struct AtomicPolicy {
+    using Counter = std::atomic<std::size_t>;
+
+    static void Increment(Counter& count) noexcept {
+        count.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    // Returns true when count has dropped to zero.
+    static bool Decrement(Counter& count) noexcept {
+        return count.fetch_sub(1, std::memory_order_acq_rel) == 1;
+    }
+
+    static bool Decrement(Counter& count, std::size_t n) noexcept {
+        return count.fetch_sub(n, std::memory_order_acq_rel) == n;
+    }
+
+    // Increments count unless it is zero; returns whether it did. Used on
+    // the strong count, where zero means for good. A failed exchange hands
+    // back the value that beat it, so a retry costs no extra load, and only
+    // the successful one pays for acquire.
+    //
+    // A wait-free fetch_add with a dead bit set by the last release does not
+    // work here: that release would have to read the count again after it
+    // reached zero, and a Lock that revived it meanwhile could free the
+    // block under it.
+    static bool IncrementIfNotZero(Counter& count) noexcept {
+        std::size_t current = count.load(std::memory_order_relaxed);
+        while (current != 0) {
+            if (count.compare_exchange_weak(current, current + 1, std::memory_order_acquire,
+                                            std::memory_order_relaxed)) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    static std::size_t Load(const Counter& count) noexcept {
+        return count.load(std::memory_order_relaxed);
+    }
+};
+
+// Plain counts for pointers that never leave the thread that made them: no
+// locked instructions at all. Sharing such a pointer between threads is a
+// data race.
+struct SingleThreadPolicy {
+    using Counter = std::size_t;
+
+    static void Increment(Counter& count) noexcept {
+        ++count;
+    }
+
+    static bool Decrement(Counter& count) noexcept {
+        return --count == 0;
+    }
+
+    static bool Decrement(Counter& count, std::size_t n) noexcept {
+        return (count -= n) == 0;
+    }
+
+    static bool IncrementIfNotZero(Counter& count) noexcept {
+        if (count == 0) {
+            return false;
+        }
+        ++count;
+        return true;
+    }
+
+    static std::size_t Load(const Counter& count) noexcept {
+        return count;
+    }
+};
+
+using DefaultLockPolicy = AtomicPolicy;
+
+// The number of SharedPtr owning the object.
+template <typename Policy = DefaultLockPolicy>
 class SharedCount {
 public:
-    // Your code goes here...
+    SharedCount(const SharedCount&) = delete;
+    SharedCount& operator=(const SharedCount&) = delete;
+
+    void AddRef() noexcept {
+        Policy::Increment(shared_);
+    }
+
+    // Takes a reference unless the object is already gone; used by
+    // WeakPtr::Lock.
+    bool TryAddRef() noexcept {
+        return Policy::IncrementIfNotZero(shared_);
+    }
+
+    std::size_t UseCount() const noexcept {
+        return Policy::Load(shared_);
+    }
 
 protected:
-    // Your code goes here...
+    SharedCount() noexcept = default;
+    virtual ~SharedCount() = default;
+
+    typename Policy::Counter shared_{1};
 };
 
-class SharedWeakCount : public SharedCount {
+// Adds the number of WeakPtr, plus one on behalf of all the SharedPtr
+// together, so the block outlives the object while a WeakPtr can see it.
+template <typename Policy = DefaultLockPolicy>
+class SharedWeakCount : public SharedCount<Policy> {
 public:
-    // Your code goes here...
+    void Release() noexcept {
+        if (Policy::Decrement(this->shared_)) {
+            Dispose();
+            ReleaseWeak();
+        }
+    }
+
+    // Drops n references at once.
+    void Release(std::size_t n) noexcept {
+        if (Policy::Decrement(this->shared_, n)) {
+            Dispose();
+            ReleaseWeak();
+        }
+    }
+
+    void AddWeakRef() noexcept {
+        Policy::Increment(weak_);
+    }
+
+    void ReleaseWeak() noexcept {
+        if (Policy::Decrement(weak_)) {
+            Destroy();
+        }
+    }
 
 protected:
-    // Your code goes here...
+    // Destroys the object.
+    virtual void Dispose() noexcept = 0;
+
+    // Frees the control block itself.
+    virtual void Destroy() noexcept {
+        delete this;
+    }
+
+    typename Policy::Counter weak_{1};
+};
+
+// A control block for an object allocated by the user, which deleter frees.
+template <typename T, typename Deleter, typename Policy = DefaultLockPolicy>
+class ControlBlock : public SharedWeakCount<Policy> {
+public:
+    ControlBlock(T* ptr, Deleter deleter) : ptr_(ptr), deleter_(std::move(deleter)) {
+    }
+
+private:
+    void Dispose() noexcept override {
+        deleter_(ptr_);
+    }
+
+    T* ptr_;
+    Deleter deleter_;
+};
+
+// A control block with the object stored inside it, so MakeShared needs a
+// single allocation. The object is destroyed with the last SharedPtr; its
+// storage goes with the block, once the last WeakPtr is gone too.
+template <typename T, typename Policy = DefaultLockPolicy>
+class InplaceControlBlock : public SharedWeakCount<Policy> {
+public:
+    template <typename... Args>
+    explicit InplaceControlBlock(Args&&... args) {
+        ::new (static_cast<void*>(&storage_)) T(std::forward<Args>(args)...);
+    }
+
+    T* Get() noexcept {
+        return std::launder(reinterpret_cast<T*>(&storage_));
+    }
+
+private:
+    void Dispose() noexcept override {
+        Get()->~T();
+    }
+
+    alignas(T) unsigned char storage_[sizeof(T)];
+};
+
+// A control block followed, in the same allocation, by an array of n
+// elements, for MakeShared<T[]>(n). The elements are destroyed last to first
+// with the last SharedPtr, as delete[] would.
+template <typename T, typename Policy = DefaultLockPolicy>
+class InplaceArrayControlBlock : public SharedWeakCount<Policy> {
+public:
+    // Copies T(args...) into every element, or value-initialises them when
+    // args is empty; for trivial types either is a plain fill.
+    template <typename... Args>
+    static InplaceArrayControlBlock* Create(std::size_t n, const Args&... args) {
+        if (n > (static_cast<std::size_t>(-1) - Offset()) / sizeof(T)) {
+            throw std::bad_array_new_length();
+        }
+        auto* block = ::new (Allocate(Offset() + n * sizeof(T))) InplaceArrayControlBlock(n);
+        try {
+            // Both destroy what they built before passing an exception on.
+            if constexpr (sizeof...(Args) == 0) {
+                std::uninitialized_value_construct_n(block->Elements(), n);
+            } else {
+                std::uninitialized_fill_n(block->Elements(), n, T(args...));
+            }
+        } catch (...) {
+            block->Destroy();
+            throw;
+        }
+        return block;
+    }
+
+    T* Get() noexcept {
+        return std::launder(Elements());
+    }
+
+private:
+    static constexpr std::size_t kAlignment =
+        alignof(T) > alignof(SharedWeakCount<Policy>) ? alignof(T)
+                                                      : alignof(SharedWeakCount<Policy>);
+
+    explicit InplaceArrayControlBlock(std::size_t n) noexcept : size_(n) {
+    }
+
+    // Where the elements start, past the block and aligned for T.
+    static constexpr std::size_t Offset() noexcept {
+        return (sizeof(InplaceArrayControlBlock) + alignof(T) - 1) / alignof(T) * alignof(T);
+    }
+
+    static void* Allocate(std::size_t bytes) {
+        if (kAlignment > __STDCPP_DEFAULT_NEW_ALIGNMENT__) {
+            return ::operator new(bytes, std::align_val_t(kAlignment));
+        }
+        return ::operator new(bytes);
+    }
+
+    T* Elements() noexcept {
+        return reinterpret_cast<T*>(reinterpret_cast<unsigned char*>(this) + Offset());
+    }
+
+    void Dispose() noexcept override {
+        // GCC keeps the empty loop for trivial types otherwise.
+        if constexpr (!std::is_trivially_destructible_v<T>) {
+            for (std::size_t i = size_; i > 0; --i) {
+                Get()[i - 1].~T();
+            }
+        }
+    }
+
+    void Destroy() noexcept override {
+        const std::size_t bytes = Offset() + size_ * sizeof(T);
+        this->~InplaceArrayControlBlock();
+        if (kAlignment > __STDCPP_DEFAULT_NEW_ALIGNMENT__) {
+            ::operator delete(this, bytes, std::align_val_t(kAlignment));
+        } else {
+            ::operator delete(this, bytes);
+        }
+    }
+
+    std::size_t size_;
 };
 
-template <typename T, typename Deleter>
-class ControlBlock : public SharedWeakCount {
+// InplaceControlBlock for AllocateShared: the block, object included, comes
+// from an allocator rebound to the block type and goes back to a copy of it.
+// The object is built and destroyed through that same copy, which saves a
+// rebind per call for allocators where rebinding is not free.
+template <typename T, typename Alloc, typename Policy = DefaultLockPolicy>
+class AllocatedControlBlock : public SharedWeakCount<Policy> {
 public:
-    // Your code goes here...
+    using block_allocator =
+        typename std::allocator_traits<Alloc>::template rebind_alloc<AllocatedControlBlock>;
+
+    template <typename... Args>
+    explicit AllocatedControlBlock(const block_allocator& alloc, Args&&... args) : alloc_(alloc) {
+        block_traits::construct(alloc_, Get(), std::forward<Args>(args)...);
+    }
+
+    T* Get() noexcept {
+        return std::launder(reinterpret_cast<T*>(&storage_));
+    }
 
 private:
-    // Your code goes here...
-};
\ No newline at end of file
+    using block_traits = std::allocator_traits<block_allocator>;
+
+    void Dispose() noexcept override {
+        block_traits::destroy(alloc_, Get());
+    }
+
+    void Destroy() noexcept override {
+        block_allocator alloc(std::move(alloc_));
+        this->~AllocatedControlBlock();
+        block_traits::deallocate(alloc, this, 1);
+    }
+
+    block_allocator alloc_;
+    alignas(T) unsigned char storage_[sizeof(T)];
+};
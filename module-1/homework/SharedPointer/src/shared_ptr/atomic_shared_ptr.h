@@ -0,0 +1,171 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+#include <utility>
+
+#include "shared_ptr.h"
+
+// A SharedPtr that threads may load and replace concurrently without a lock,
+// for publishing snapshots that many readers pick up.
+//
+// Reference counts are split. The current value sits in a Holder on the
+// heap, and the atomic word packs the Holder's address with a local count in
+// its top 16 bits. Load raises the local count with one fetch_add, which pins
+// the Holder, copies the SharedPtr out of it and drops the pin again, with a
+// compare-exchange while the Holder is still installed, or else through the
+// Holder's own count. Whoever swaps a Holder out moves the local count it
+// saw over to the Holder's count, so the last of the swapper and the pinned
+// readers frees it. Stores allocate a Holder; loads never allocate. The
+// local count has room for 65535 loads in flight at once.
+template <typename T>
+class AtomicSharedPtr {
+public:
+    using value_type = SharedPtr<T>;
+
+    constexpr AtomicSharedPtr() noexcept = default;
+
+    explicit AtomicSharedPtr(SharedPtr<T> desired) : word_(Pack(MakeHolder(std::move(desired)))) {
+    }
+
+    AtomicSharedPtr(const AtomicSharedPtr&) = delete;
+    AtomicSharedPtr& operator=(const AtomicSharedPtr&) = delete;
+
+    ~AtomicSharedPtr() {
+        // Nobody else may touch the object any more, so no pins are left.
+        delete Unpack(word_.load(std::memory_order_acquire));
+    }
+
+    SharedPtr<T> Load() const {
+        Holder* holder = Unpack(word_.fetch_add(kOne, std::memory_order_acquire));
+        SharedPtr<T> result = holder == nullptr ? SharedPtr<T>() : holder->value;
+        Unpin(holder);
+        return result;
+    }
+
+    void Store(SharedPtr<T> desired) {
+        Exchange(std::move(desired));
+    }
+
+    SharedPtr<T> Exchange(SharedPtr<T> desired) {
+        Holder* holder = MakeHolder(std::move(desired));
+        const std::uintptr_t old = word_.exchange(Pack(holder), std::memory_order_acq_rel);
+        return Retire(old);
+    }
+
+    // Replaces the value with desired if it still owns the same object as
+    // expected, pointer and control block alike. Otherwise loads the current
+    // value into expected. Returns whether it replaced.
+    bool CompareExchange(SharedPtr<T>& expected, SharedPtr<T> desired) {
+        Holder* replacement = nullptr;
+        while (true) {
+            std::uintptr_t word = word_.fetch_add(kOne, std::memory_order_acq_rel) + kOne;
+            Holder* holder = Unpack(word);
+            if (!Holds(holder, expected)) {
+                expected = holder == nullptr ? SharedPtr<T>() : holder->value;
+                Unpin(holder);
+                delete replacement;
+                return false;
+            }
+            if (replacement == nullptr && (desired.control_ != nullptr || desired)) {
+                replacement = new Holder{std::move(desired)};
+            }
+            // Readers may pin and unpin meanwhile; only the Holder has to stay.
+            while (Unpack(word) == holder) {
+                if (word_.compare_exchange_weak(word, Pack(replacement),
+                                                std::memory_order_acq_rel,
+                                                std::memory_order_acquire)) {
+                    // Our own pin is among those handed over; count it as
+                    // released right away.
+                    Transfer(holder, LocalCount(word) - 1);
+                    return true;
+                }
+            }
+            Unpin(holder);
+        }
+    }
+
+    bool IsLockFree() const noexcept {
+        return word_.is_lock_free();
+    }
+
+private:
+    struct Holder {
+        SharedPtr<T> value;
+        // Pins released after the Holder was swapped out, minus the ones the
+        // swapper handed over.
+        std::atomic<std::int64_t> refs{0};
+    };
+
+    static_assert(sizeof(void*) == 8, "the local count lives in the top bits of a pointer");
+
+    static constexpr int kCountShift = 48;
+    static constexpr std::uintptr_t kOne = std::uintptr_t(1) << kCountShift;
+    static constexpr std::uintptr_t kPointerMask = kOne - 1;
+
+    static std::uintptr_t Pack(Holder* holder) noexcept {
+        return reinterpret_cast<std::uintptr_t>(holder);
+    }
+
+    static Holder* Unpack(std::uintptr_t word) noexcept {
+        return reinterpret_cast<Holder*>(word & kPointerMask);
+    }
+
+    static std::int64_t LocalCount(std::uintptr_t word) noexcept {
+        return static_cast<std::int64_t>(word >> kCountShift);
+    }
+
+    static Holder* MakeHolder(SharedPtr<T> value) {
+        if (value.control_ == nullptr && !value) {
+            return nullptr;
+        }
+        return new Holder{std::move(value)};
+    }
+
+    static bool Holds(const Holder* holder, const SharedPtr<T>& expected) noexcept {
+        if (holder == nullptr) {
+            return expected.control_ == nullptr && !expected;
+        }
+        return holder->value.control_ == expected.control_ &&
+               holder->value.Get() == expected.Get();
+    }
+
+    // Drops a pin taken by fetch_add: from the word if holder is still
+    // installed, otherwise from the Holder, which the swapper charged for it.
+    // Pins on an empty value protect nothing and die with the word when it
+    // is replaced, so they are only dropped while there are any left.
+    void Unpin(Holder* holder) const noexcept {
+        std::uintptr_t word = word_.load(std::memory_order_relaxed);
+        while (Unpack(word) == holder && (holder != nullptr || LocalCount(word) > 0)) {
+            if (word_.compare_exchange_weak(word, word - kOne, std::memory_order_release,
+                                            std::memory_order_relaxed)) {
+                return;
+            }
+        }
+        if (holder != nullptr && holder->refs.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+            delete holder;
+        }
+    }
+
+    static void Transfer(Holder* holder, std::int64_t pins) noexcept {
+        if (holder != nullptr &&
+            holder->refs.fetch_add(pins, std::memory_order_acq_rel) + pins == 0) {
+            delete holder;
+        }
+    }
+
+    // Takes over a word just swapped out of word_ and returns its value.
+    static SharedPtr<T> Retire(std::uintptr_t word) noexcept {
+        Holder* holder = Unpack(word);
+        if (holder == nullptr) {
+            return SharedPtr<T>();
+        }
+        SharedPtr<T> result = holder->value;
+        Transfer(holder, LocalCount(word));
+        return result;
+    }
+
+    mutable std::atomic<std::uintptr_t> word_{0};
+};
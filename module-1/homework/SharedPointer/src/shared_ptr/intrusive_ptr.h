@@ -0,0 +1,149 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <utility>
+
+#include "../control/control.h"
+#include "shared_ptr.h"
+
+// Base for objects that keep their own reference count, for IntrusivePtr:
+// class Node : public RefCounted<Node> { ... };
+// The count sits in the object, so copying a pointer or reading through it
+// touches one cache line rather than the object and a control block.
+// Policy is a lock policy from control.h; Deleter destroys the object when
+// the count drops to zero and is default-constructed to do so.
+template <typename T, typename Policy = DefaultLockPolicy,
+          typename Deleter = std::default_delete<T>>
+class RefCounted {
+public:
+    void AddRef() const noexcept {
+        Policy::Increment(refs_);
+    }
+
+    void Release() const noexcept {
+        if (Policy::Decrement(refs_)) {
+            Deleter()(static_cast<T*>(const_cast<RefCounted*>(this)));
+        }
+    }
+
+    std::size_t UseCount() const noexcept {
+        return Policy::Load(refs_);
+    }
+
+protected:
+    RefCounted() noexcept = default;
+
+    // A copy of an object is a new object with no references yet.
+    RefCounted(const RefCounted&) noexcept {
+    }
+
+    RefCounted& operator=(const RefCounted&) noexcept {
+        return *this;
+    }
+
+    ~RefCounted() = default;
+
+private:
+    mutable typename Policy::Counter refs_{0};
+};
+
+// A pointer to an object derived from RefCounted, which owns a reference
+// while it is not empty. Any raw pointer to such an object can become an
+// IntrusivePtr, since the count travels with the object.
+template <typename T>
+class IntrusivePtr {
+public:
+    using element_type = T;
+
+    constexpr IntrusivePtr() noexcept = default;
+
+    explicit IntrusivePtr(T* p) noexcept : ptr_(p) {
+        if (ptr_ != nullptr) {
+            ptr_->AddRef();
+        }
+    }
+
+    IntrusivePtr(const IntrusivePtr& other) noexcept : IntrusivePtr(other.ptr_) {
+    }
+
+    IntrusivePtr(IntrusivePtr&& other) noexcept : ptr_(std::exchange(other.ptr_, nullptr)) {
+    }
+
+    template <typename Y>
+    IntrusivePtr(const IntrusivePtr<Y>& other) noexcept : IntrusivePtr(other.Get()) {  // NOLINT
+    }
+
+    IntrusivePtr& operator=(const IntrusivePtr& other) noexcept {
+        IntrusivePtr(other).Swap(*this);
+        return *this;
+    }
+
+    IntrusivePtr& operator=(IntrusivePtr&& other) noexcept {
+        IntrusivePtr(std::move(other)).Swap(*this);
+        return *this;
+    }
+
+    ~IntrusivePtr() {
+        if (ptr_ != nullptr) {
+            ptr_->Release();
+        }
+    }
+
+    // Modifiers
+    void Reset() noexcept {
+        IntrusivePtr().Swap(*this);
+    }
+
+    void Reset(T* p) noexcept {
+        IntrusivePtr(p).Swap(*this);
+    }
+
+    void Swap(IntrusivePtr& other) noexcept {
+        std::swap(ptr_, other.ptr_);
+    }
+
+    // Observers
+    T* Get() const noexcept {
+        return ptr_;
+    }
+
+    int64_t UseCount() const noexcept {
+        return ptr_ == nullptr ? 0 : static_cast<int64_t>(ptr_->UseCount());
+    }
+
+    T& operator*() const noexcept {
+        return *ptr_;
+    }
+
+    T* operator->() const noexcept {
+        return ptr_;
+    }
+
+    explicit operator bool() const noexcept {
+        return ptr_ != nullptr;
+    }
+
+    // A SharedPtr that holds one intrusive reference and drops it when its
+    // last copy goes; needs a control block allocation. Its Get() may be
+    // turned back into an IntrusivePtr at any time.
+    template <typename Policy = DefaultLockPolicy>
+    SharedPtr<T, Policy> ToShared() const {
+        if (ptr_ == nullptr) {
+            return SharedPtr<T, Policy>();
+        }
+        ptr_->AddRef();
+        return SharedPtr<T, Policy>(ptr_, [](T* p) { p->Release(); });
+    }
+
+private:
+    T* ptr_ = nullptr;
+};
+
+// MakeIntrusive
+template <typename T, typename... Args>
+IntrusivePtr<T> MakeIntrusive(Args&&... args) {
+    return IntrusivePtr<T>(new T(std::forward<Args>(args)...));
+}
+// MakeIntrusive
@@ -0,0 +1,28 @@
+#pragma once
+
+#include "../../../Optional/optional.h"
+#include "shared_ptr.h"
+
+namespace task {
+
+// Makes task::Optional<SharedPtr<T>> no bigger than SharedPtr itself. The
+// sentinel owns nothing and points where the niche of a plain pointer does,
+// which no object can occupy, so an empty SharedPtr is still a value. It
+// costs no allocation, and telling it apart takes one comparison.
+//
+// shared_ptr.h includes this header, so that no translation unit can see
+// SharedPtr without the specialization and lay the Optional out differently.
+template <typename T, typename Policy>
+struct OptionalNiche<SharedPtr<T, Policy>> {
+    using PointerNiche = OptionalNiche<typename SharedPtr<T, Policy>::element_type*>;
+
+    static SharedPtr<T, Policy> Empty() noexcept {
+        return SharedPtr<T, Policy>(SharedPtr<T, Policy>(), PointerNiche::Empty());
+    }
+
+    static bool IsEmpty(const SharedPtr<T, Policy>& value) noexcept {
+        return PointerNiche::IsEmpty(value.Get());
+    }
+};
+
+}  // namespace task
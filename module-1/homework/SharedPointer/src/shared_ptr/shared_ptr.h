@@ -1,15 +1,41 @@
 #pragma once
 
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+
 #include "../control/control.h"
 
 // SharedPtr
-template <typename T>
+template <typename T, typename Policy = DefaultLockPolicy>
 class WeakPtr;
 
+template <typename T, typename Policy = DefaultLockPolicy>
+class SharedPtr;
+
 template <typename T>
+class AtomicSharedPtr;
+
+template <typename Policy>
+class SharedPtrReleaseBatch;
+
+template <typename T, typename Policy = DefaultLockPolicy, typename... Args>
+SharedPtr<T, Policy> MakeShared(Args&&... args);
+
+template <typename T, typename Policy = DefaultLockPolicy, typename Alloc, typename... Args>
+SharedPtr<T, Policy> AllocateShared(const Alloc& alloc, Args&&... args);
+
+// Policy is a lock policy from control.h. SharedPtr<T, SingleThreadPolicy>
+// counts without atomics and must stay on the thread that created the
+// object; pointers with different policies never share a control block.
+template <typename T, typename Policy>
 class SharedPtr {
 public:
-    using element_type =     // Your code goes here...
+    using element_type = std::remove_extent_t<T>;
+    using weak_type = WeakPtr<T, Policy>;
 
     constexpr SharedPtr() noexcept = default;
     ~SharedPtr();
@@ -23,15 +49,29 @@ public:
     SharedPtr(const SharedPtr& other) noexcept;
     SharedPtr(SharedPtr&& other) noexcept;
 
+    template <typename Y>
+    SharedPtr(const SharedPtr<Y, Policy>& other) noexcept;  // NOLINT
+
+    template <typename Y>
+    SharedPtr(SharedPtr<Y, Policy>&& other) noexcept;  // NOLINT
+
+    // Aliasing: shares ownership with other but points to ptr, usually a
+    // part of the object other owns. Only the shared count changes.
+    template <typename Y>
+    SharedPtr(const SharedPtr<Y, Policy>& other, element_type* ptr) noexcept;
+
+    template <typename Y>
+    SharedPtr(SharedPtr<Y, Policy>&& other, element_type* ptr) noexcept;
+
     SharedPtr& operator=(const SharedPtr& r) noexcept;
 
     template <typename Y>
-    SharedPtr& operator=(const SharedPtr<Y>& r) noexcept;
+    SharedPtr& operator=(const SharedPtr<Y, Policy>& r) noexcept;
 
     SharedPtr& operator=(SharedPtr&& r) noexcept;
 
     template <typename Y>
-    SharedPtr& operator=(SharedPtr<Y>&& r) noexcept;
+    SharedPtr& operator=(SharedPtr<Y, Policy>&& r) noexcept;
 
     // Modifiers
     void Reset() noexcept;
@@ -45,44 +85,260 @@ public:
     void Swap(SharedPtr& other) noexcept;
 
     // Observers
-    T* Get() const noexcept;
+    element_type* Get() const noexcept;
     int64_t UseCount() const noexcept;
-    T& operator*() const noexcept;
-    T* operator->() const noexcept;
+    element_type& operator*() const noexcept;
+    element_type* operator->() const noexcept;
     element_type& operator[](std::ptrdiff_t idx) const;
     explicit operator bool() const noexcept;
 
-    template <typename U>
+    template <typename U, typename P>
+    friend class SharedPtr;
+
+    template <typename U, typename P>
     friend class WeakPtr;
 
+    template <typename U>
+    friend class AtomicSharedPtr;
+
+    template <typename P>
+    friend class SharedPtrReleaseBatch;
+
+    template <typename U, typename P, typename... Args>
+    friend SharedPtr<U, P> MakeShared(Args&&... args);
+
+    template <typename U, typename P, typename Alloc, typename... Args>
+    friend SharedPtr<U, P> AllocateShared(const Alloc& alloc, Args&&... args);
+
 private:
-    // Your code goes here...
-};
+    // What SharedPtr(Y*) frees the pointer with: delete[] for arrays.
+    template <typename Y>
+    using DefaultDelete =
+        std::conditional_t<std::is_array_v<T>, std::default_delete<element_type[]>,
+                           std::default_delete<Y>>;
 
+    // Adopts a reference already counted in control.
+    SharedPtr(element_type* ptr, SharedWeakCount<Policy>* control) noexcept;
+
+    element_type* ptr_ = nullptr;
+    SharedWeakCount<Policy>* control_ = nullptr;
+};
 
 // MakeShared
-// Your code goes here...
+// Creates the object inside its control block: one allocation instead of
+// the two SharedPtr(new T) makes, and the object sits next to its counts.
+// For arrays the elements follow the block: MakeShared<T[]>(n) and
+// MakeShared<T[N]>() value-initialise them, MakeShared<T[]>(n, value) and
+// MakeShared<T[N]>(value) copy value into each.
+template <typename T, typename Policy, typename... Args>
+SharedPtr<T, Policy> MakeShared(Args&&... args) {
+    if constexpr (std::is_array_v<T>) {
+        using Block = InplaceArrayControlBlock<std::remove_extent_t<T>, Policy>;
+        Block* block = nullptr;
+        if constexpr (std::extent_v<T> == 0) {
+            block = Block::Create(args...);
+        } else {
+            block = Block::Create(std::extent_v<T>, args...);
+        }
+        SharedWeakCount<Policy>* control = block;
+        return SharedPtr<T, Policy>(block->Get(), control);
+    } else {
+        auto* block = new InplaceControlBlock<T, Policy>(std::forward<Args>(args)...);
+        // Passed as the base, or the pointer-and-deleter constructor would win.
+        SharedWeakCount<Policy>* control = block;
+        return SharedPtr<T, Policy>(block->Get(), control);
+    }
+}
+
+// Like MakeShared, with the single allocation taken from alloc, which is
+// rebound to the control block type; a copy of it frees the block.
+template <typename T, typename Policy, typename Alloc, typename... Args>
+SharedPtr<T, Policy> AllocateShared(const Alloc& alloc, Args&&... args) {
+    using Block = AllocatedControlBlock<T, Alloc, Policy>;
+    using BlockTraits = std::allocator_traits<typename Block::block_allocator>;
+    typename Block::block_allocator block_alloc(alloc);
+    Block* block = BlockTraits::allocate(block_alloc, 1);
+    try {
+        ::new (static_cast<void*>(block)) Block(block_alloc, std::forward<Args>(args)...);
+    } catch (...) {
+        BlockTraits::deallocate(block_alloc, block, 1);
+        throw;
+    }
+    SharedWeakCount<Policy>* control = block;
+    return SharedPtr<T, Policy>(block->Get(), control);
+}
 // MakeShared
 
 // SharedPtr
-// Your code goes here...
+template <typename T, typename Policy>
+SharedPtr<T, Policy>::~SharedPtr() {
+    if (control_ != nullptr) {
+        control_->Release();
+    }
+}
+
+template <typename T, typename Policy>
+template <typename Y>
+SharedPtr<T, Policy>::SharedPtr(Y* p) : ptr_(p) {
+    try {
+        control_ = new ControlBlock<Y, DefaultDelete<Y>, Policy>(p, {});
+    } catch (...) {
+        DefaultDelete<Y>()(p);
+        throw;
+    }
+}
+
+template <typename T, typename Policy>
+template <typename Y, typename Deleter>
+SharedPtr<T, Policy>::SharedPtr(Y* p, Deleter deleter) noexcept
+    : ptr_(p), control_(new ControlBlock<Y, Deleter, Policy>(p, std::move(deleter))) {
+}
+
+template <typename T, typename Policy>
+SharedPtr<T, Policy>::SharedPtr(const SharedPtr& other) noexcept
+    : ptr_(other.ptr_), control_(other.control_) {
+    if (control_ != nullptr) {
+        control_->AddRef();
+    }
+}
+
+template <typename T, typename Policy>
+SharedPtr<T, Policy>::SharedPtr(SharedPtr&& other) noexcept
+    : ptr_(std::exchange(other.ptr_, nullptr)), control_(std::exchange(other.control_, nullptr)) {
+}
+
+template <typename T, typename Policy>
+template <typename Y>
+SharedPtr<T, Policy>::SharedPtr(const SharedPtr<Y, Policy>& other) noexcept
+    : ptr_(other.ptr_), control_(other.control_) {
+    if (control_ != nullptr) {
+        control_->AddRef();
+    }
+}
+
+template <typename T, typename Policy>
+template <typename Y>
+SharedPtr<T, Policy>::SharedPtr(SharedPtr<Y, Policy>&& other) noexcept
+    : ptr_(std::exchange(other.ptr_, nullptr)), control_(std::exchange(other.control_, nullptr)) {
+}
+
+template <typename T, typename Policy>
+template <typename Y>
+SharedPtr<T, Policy>::SharedPtr(const SharedPtr<Y, Policy>& other, element_type* ptr) noexcept
+    : ptr_(ptr), control_(other.control_) {
+    if (control_ != nullptr) {
+        control_->AddRef();
+    }
+}
+
+template <typename T, typename Policy>
+template <typename Y>
+SharedPtr<T, Policy>::SharedPtr(SharedPtr<Y, Policy>&& other, element_type* ptr) noexcept
+    : ptr_(ptr), control_(std::exchange(other.control_, nullptr)) {
+    other.ptr_ = nullptr;
+}
+
+template <typename T, typename Policy>
+SharedPtr<T, Policy>::SharedPtr(element_type* ptr, SharedWeakCount<Policy>* control) noexcept
+    : ptr_(ptr), control_(control) {
+}
+
+template <typename T, typename Policy>
+SharedPtr<T, Policy>& SharedPtr<T, Policy>::operator=(const SharedPtr& r) noexcept {
+    SharedPtr(r).Swap(*this);
+    return *this;
+}
+
+template <typename T, typename Policy>
+template <typename Y>
+SharedPtr<T, Policy>& SharedPtr<T, Policy>::operator=(const SharedPtr<Y, Policy>& r) noexcept {
+    SharedPtr(r).Swap(*this);
+    return *this;
+}
+
+template <typename T, typename Policy>
+SharedPtr<T, Policy>& SharedPtr<T, Policy>::operator=(SharedPtr&& r) noexcept {
+    SharedPtr(std::move(r)).Swap(*this);
+    return *this;
+}
+
+template <typename T, typename Policy>
+template <typename Y>
+SharedPtr<T, Policy>& SharedPtr<T, Policy>::operator=(SharedPtr<Y, Policy>&& r) noexcept {
+    SharedPtr(std::move(r)).Swap(*this);
+    return *this;
+}
+
+template <typename T, typename Policy>
+void SharedPtr<T, Policy>::Reset() noexcept {
+    SharedPtr().Swap(*this);
+}
+
+template <typename T, typename Policy>
+template <typename Y>
+void SharedPtr<T, Policy>::Reset(Y* p) noexcept {
+    SharedPtr(p).Swap(*this);
+}
+
+template <typename T, typename Policy>
+template <typename Y, typename Deleter>
+void SharedPtr<T, Policy>::Reset(Y* p, Deleter deleter) noexcept {
+    SharedPtr(p, std::move(deleter)).Swap(*this);
+}
+
+template <typename T, typename Policy>
+void SharedPtr<T, Policy>::Swap(SharedPtr& other) noexcept {
+    std::swap(ptr_, other.ptr_);
+    std::swap(control_, other.control_);
+}
+
+template <typename T, typename Policy>
+typename SharedPtr<T, Policy>::element_type* SharedPtr<T, Policy>::Get() const noexcept {
+    return ptr_;
+}
+
+template <typename T, typename Policy>
+int64_t SharedPtr<T, Policy>::UseCount() const noexcept {
+    return control_ == nullptr ? 0 : static_cast<int64_t>(control_->UseCount());
+}
+
+template <typename T, typename Policy>
+typename SharedPtr<T, Policy>::element_type& SharedPtr<T, Policy>::operator*() const noexcept {
+    return *ptr_;
+}
+
+template <typename T, typename Policy>
+typename SharedPtr<T, Policy>::element_type* SharedPtr<T, Policy>::operator->() const noexcept {
+    return ptr_;
+}
+
+template <typename T, typename Policy>
+typename SharedPtr<T, Policy>::element_type& SharedPtr<T, Policy>::operator[](
+    std::ptrdiff_t idx) const {
+    return ptr_[idx];
+}
+
+template <typename T, typename Policy>
+SharedPtr<T, Policy>::operator bool() const noexcept {
+    return ptr_ != nullptr;
+}
 // SharedPtr
 
 // WeakPtr
-template <typename T>
+template <typename T, typename Policy>
 class WeakPtr {
 
 public:
-    using element_type =     // Your code goes here...
+    using element_type = std::remove_extent_t<T>;
 
     // Special-member functions
     constexpr WeakPtr() noexcept = default;
     template <typename Y>
-    explicit WeakPtr(const SharedPtr<Y>& other);
+    explicit WeakPtr(const SharedPtr<Y, Policy>& other);
     WeakPtr(const WeakPtr& other) noexcept;
     WeakPtr(WeakPtr&& other) noexcept;
     template <typename Y>
-    WeakPtr& operator=(const SharedPtr<Y>& other);
+    WeakPtr& operator=(const SharedPtr<Y, Policy>& other);
     WeakPtr& operator=(const WeakPtr& other) noexcept;
     WeakPtr& operator=(WeakPtr&& other) noexcept;
 
@@ -90,19 +346,96 @@ public:
 
     // Modifiers
     void Reset() noexcept;
-    void Swap(WeakPtr<T>& other) noexcept;
+    void Swap(WeakPtr& other) noexcept;
 
     // Observers
-    bool Expired() noexcept;
-    SharedPtr<T> Lock() const noexcept;
+    bool Expired() const noexcept;
+    SharedPtr<T, Policy> Lock() const noexcept;
 
-    template <typename U>
+    template <typename U, typename P>
     friend class SharedPtr;
 
-public:
-    // Your code goes here...
+private:
+    element_type* ptr_ = nullptr;
+    SharedWeakCount<Policy>* control_ = nullptr;
 };
 
 // WeakPtr
-// Your code goes here...
-// WeakPtr
\ No newline at end of file
+template <typename T, typename Policy>
+template <typename Y>
+WeakPtr<T, Policy>::WeakPtr(const SharedPtr<Y, Policy>& other)
+    : ptr_(other.ptr_), control_(other.control_) {
+    if (control_ != nullptr) {
+        control_->AddWeakRef();
+    }
+}
+
+template <typename T, typename Policy>
+WeakPtr<T, Policy>::WeakPtr(const WeakPtr& other) noexcept
+    : ptr_(other.ptr_), control_(other.control_) {
+    if (control_ != nullptr) {
+        control_->AddWeakRef();
+    }
+}
+
+template <typename T, typename Policy>
+WeakPtr<T, Policy>::WeakPtr(WeakPtr&& other) noexcept
+    : ptr_(std::exchange(other.ptr_, nullptr)), control_(std::exchange(other.control_, nullptr)) {
+}
+
+template <typename T, typename Policy>
+template <typename Y>
+WeakPtr<T, Policy>& WeakPtr<T, Policy>::operator=(const SharedPtr<Y, Policy>& other) {
+    WeakPtr(other).Swap(*this);
+    return *this;
+}
+
+template <typename T, typename Policy>
+WeakPtr<T, Policy>& WeakPtr<T, Policy>::operator=(const WeakPtr& other) noexcept {
+    WeakPtr(other).Swap(*this);
+    return *this;
+}
+
+template <typename T, typename Policy>
+WeakPtr<T, Policy>& WeakPtr<T, Policy>::operator=(WeakPtr&& other) noexcept {
+    WeakPtr(std::move(other)).Swap(*this);
+    return *this;
+}
+
+template <typename T, typename Policy>
+WeakPtr<T, Policy>::~WeakPtr() {
+    if (control_ != nullptr) {
+        control_->ReleaseWeak();
+    }
+}
+
+template <typename T, typename Policy>
+void WeakPtr<T, Policy>::Reset() noexcept {
+    WeakPtr().Swap(*this);
+}
+
+template <typename T, typename Policy>
+void WeakPtr<T, Policy>::Swap(WeakPtr& other) noexcept {
+    std::swap(ptr_, other.ptr_);
+    std::swap(control_, other.control_);
+}
+
+// A single relaxed load. Zero is final, so true stays true, but false may be
+// stale as soon as it is read; Lock is the way to get at the object.
+template <typename T, typename Policy>
+bool WeakPtr<T, Policy>::Expired() const noexcept {
+    return control_ == nullptr || control_->UseCount() == 0;
+}
+
+template <typename T, typename Policy>
+SharedPtr<T, Policy> WeakPtr<T, Policy>::Lock() const noexcept {
+    if (control_ == nullptr || !control_->TryAddRef()) {
+        return SharedPtr<T, Policy>();
+    }
+    return SharedPtr<T, Policy>(ptr_, control_);
+}
+// WeakPtr
+
+// task::Optional<SharedPtr<T>> has to get the same layout in every
+// translation unit, so its niche comes along with SharedPtr.
+#include "optional_niche.h"
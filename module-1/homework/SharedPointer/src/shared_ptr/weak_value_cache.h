@@ -0,0 +1,163 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <unordered_map>
+#include <utility>
+
+#include "shared_ptr.h"
+
+struct WeakValueCacheStats {
+    std::size_t hits = 0;
+    std::size_t misses = 0;
+    // Expired entries removed, by lookups that ran into them or by sweeping.
+    std::size_t swept = 0;
+};
+
+// A map from keys to objects that the cache does not keep alive: it holds a
+// WeakPtr to each value, and an entry is as good as gone once the last
+// SharedPtr to its object is.
+//
+// Expired entries are dropped lazily. A lookup that finds one erases it, and
+// every insertion sweeps the next few buckets of its shard, so that the
+// shard is swept end to end once for roughly every bucket_count / kSweepBuckets
+// insertions, without ever pausing for a full pass.
+//
+// Keys are spread over kShards shards, each a map with its own mutex on its
+// own cache line, so threads working on different keys seldom wait for each
+// other.
+template <typename K, typename T, typename Hash = std::hash<K>,
+          typename KeyEqual = std::equal_to<K>>
+class WeakValueCache {
+public:
+    WeakValueCache() = default;
+
+    WeakValueCache(const WeakValueCache&) = delete;
+    WeakValueCache& operator=(const WeakValueCache&) = delete;
+
+    // The value for key if it is still alive, otherwise an empty pointer.
+    SharedPtr<T> Find(const K& key) {
+        Shard& shard = ShardOf(key);
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        return shard.Lookup(key);
+    }
+
+    // Makes key refer to value, replacing whatever it referred to.
+    void Insert(const K& key, const SharedPtr<T>& value) {
+        Shard& shard = ShardOf(key);
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        shard.entries.insert_or_assign(key, WeakPtr<T>(value));
+        shard.SweepSome();
+    }
+
+    // The live value for key, or else a new one made by make(), which is
+    // called with the shard locked and must not use the cache.
+    template <typename Make>
+    SharedPtr<T> GetOrCreate(const K& key, Make make) {
+        Shard& shard = ShardOf(key);
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        SharedPtr<T> value = shard.Lookup(key);
+        if (!value) {
+            value = make();
+            shard.entries.insert_or_assign(key, WeakPtr<T>(value));
+            shard.SweepSome();
+        }
+        return value;
+    }
+
+    void Erase(const K& key) {
+        Shard& shard = ShardOf(key);
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        shard.entries.erase(key);
+    }
+
+    // Entries held, expired ones that are not swept yet included.
+    std::size_t Size() const {
+        std::size_t size = 0;
+        for (const Shard& shard : shards_) {
+            std::lock_guard<std::mutex> lock(shard.mutex);
+            size += shard.entries.size();
+        }
+        return size;
+    }
+
+    WeakValueCacheStats Stats() const {
+        WeakValueCacheStats total;
+        for (const Shard& shard : shards_) {
+            std::lock_guard<std::mutex> lock(shard.mutex);
+            total.hits += shard.stats.hits;
+            total.misses += shard.stats.misses;
+            total.swept += shard.stats.swept;
+        }
+        return total;
+    }
+
+private:
+    static constexpr std::size_t kShards = 16;
+    static constexpr std::size_t kSweepBuckets = 2;
+    static constexpr std::size_t kCacheLineSize = 64;
+    static_assert(kShards == 16, "ShardOf takes the top four bits of a hash");
+
+    struct alignas(kCacheLineSize) Shard {
+        SharedPtr<T> Lookup(const K& key) {
+            auto it = entries.find(key);
+            if (it == entries.end()) {
+                ++stats.misses;
+                return SharedPtr<T>();
+            }
+            SharedPtr<T> value = it->second.Lock();
+            if (!value) {
+                entries.erase(it);
+                ++stats.misses;
+                ++stats.swept;
+                return value;
+            }
+            ++stats.hits;
+            return value;
+        }
+
+        // Drops the expired entries of the next kSweepBuckets buckets. A
+        // rehash only moves the cursor to other entries, which is harmless.
+        void SweepSome() {
+            for (std::size_t step = 0; step < kSweepBuckets; ++step) {
+                if (cursor >= entries.bucket_count()) {
+                    cursor = 0;
+                }
+                SweepBucket(cursor++);
+            }
+        }
+
+        // Buckets hold about one entry each, so a rescan after each erase,
+        // which invalidates the bucket's iterators, costs next to nothing.
+        void SweepBucket(std::size_t bucket) {
+            bool erased = true;
+            while (erased) {
+                erased = false;
+                for (auto it = entries.begin(bucket); it != entries.end(bucket); ++it) {
+                    if (it->second.Expired()) {
+                        entries.erase(entries.find(it->first));
+                        ++stats.swept;
+                        erased = true;
+                        break;
+                    }
+                }
+            }
+        }
+
+        mutable std::mutex mutex;
+        std::unordered_map<K, WeakPtr<T>, Hash, KeyEqual> entries;
+        std::size_t cursor = 0;
+        WeakValueCacheStats stats;
+    };
+
+    // Multiplying carries every bit of the hash into the top four, so that
+    // even a weak hash, such as the identity for integers, fills all shards.
+    Shard& ShardOf(const K& key) {
+        const std::uint64_t hash = static_cast<std::uint64_t>(Hash()(key));
+        return shards_[(hash * 0x9E3779B97F4A7C15ull) >> 60];
+    }
+
+    Shard shards_[kShards];
+};
@@ -1,8 +1,16 @@
 #include <algorithm>
+#include <atomic>
+#include <cstdint>
 #include <string>
+#include <thread>
+#include <vector>
 
 #include "gtest/gtest.h"
+#include "src/shared_ptr/atomic_shared_ptr.h"
+#include "src/shared_ptr/intrusive_ptr.h"
+#include "src/shared_ptr/release_batch.h"
 #include "src/shared_ptr/shared_ptr.h"
+#include "src/shared_ptr/weak_value_cache.h"
 
 // WeakPtr
 TEST(WeakExpired, Test1) {
@@ -157,6 +165,484 @@ TEST(SharedBoolOperator, Test2) {
     ASSERT_FALSE(s1);
 }
 
+// MakeShared
+TEST(MakeShared, DestroysObjectBeforeBlock) {
+    struct Counted {
+        explicit Counted(int& destroyed) : destroyed(destroyed) {
+        }
+        ~Counted() {
+            ++destroyed;
+        }
+        int& destroyed;
+    };
+
+    int destroyed = 0;
+    WeakPtr<Counted> w;
+    {
+        SharedPtr<Counted> s = MakeShared<Counted>(destroyed);
+        w = s;
+        ASSERT_TRUE(&s->destroyed == &destroyed && destroyed == 0);
+    }
+    ASSERT_TRUE(destroyed == 1 && w.Expired());
+    w.Reset();
+    ASSERT_TRUE(destroyed == 1);
+}
+
+TEST(MakeShared, OverAligned) {
+    struct alignas(64) Line {
+        char bytes[64];
+    };
+    auto s = MakeShared<Line>();
+    ASSERT_TRUE(reinterpret_cast<std::uintptr_t>(s.Get()) % 64 == 0);
+}
+
+// Arrays and aliasing
+TEST(SharedArray, OwnsNewArray) {
+    SharedPtr<std::string[]> s(new std::string[3]{"a", "b", "c"});
+    SharedPtr<std::string[]> copy = s;
+    ASSERT_TRUE(copy[2] == "c" && s.UseCount() == 2);
+}
+
+TEST(MakeShared, Array) {
+    auto zeros = MakeShared<int[]>(5);
+    ASSERT_TRUE(std::all_of(zeros.Get(), zeros.Get() + 5, [](int x) { return x == 0; }));
+    auto filled = MakeShared<std::string[]>(3, "x");
+    ASSERT_TRUE(filled[0] == "x" && filled[2] == "x");
+    auto bounded = MakeShared<int[4]>(7);
+    ASSERT_TRUE(bounded[0] == 7 && bounded[3] == 7);
+
+    struct alignas(64) Line {
+        char bytes[64];
+    };
+    auto lines = MakeShared<Line[]>(2);
+    ASSERT_TRUE(reinterpret_cast<std::uintptr_t>(lines.Get()) % 64 == 0);
+}
+
+TEST(MakeShared, ArrayDestroysLastToFirst) {
+    struct Ordered {
+        ~Ordered() {
+            order->push_back(this);
+        }
+        std::vector<const Ordered*>* order = nullptr;
+    };
+
+    std::vector<const Ordered*> order;
+    {
+        auto s = MakeShared<Ordered[]>(3);
+        for (int i = 0; i < 3; ++i) {
+            s[i].order = &order;
+        }
+        ASSERT_TRUE(order.empty());
+    }
+    ASSERT_TRUE(order.size() == 3 && order[0] > order[1] && order[1] > order[2]);
+}
+
+// The third one built throws.
+struct ThrowingElement {
+    ThrowingElement() {
+        if (++alive == 3) {
+            --alive;
+            throw 1;
+        }
+    }
+    ~ThrowingElement() {
+        --alive;
+    }
+    static int alive;
+};
+
+int ThrowingElement::alive = 0;
+
+TEST(MakeShared, ArrayUndoesPartialConstruction) {
+    ASSERT_THROW(MakeShared<ThrowingElement[]>(5), int);
+    ASSERT_TRUE(ThrowingElement::alive == 0);
+}
+
+TEST(SharedAliasing, SharesOwnership) {
+    auto pair = MakeShared<std::pair<std::string, int>>("first", 2);
+    WeakPtr<std::pair<std::string, int>> weak(pair);
+    SharedPtr<int> second(pair, &pair->second);
+    ASSERT_TRUE(*second == 2 && pair.UseCount() == 2);
+
+    pair.Reset();
+    ASSERT_TRUE(!weak.Expired() && *second == 2);
+    int* target = second.Get();
+    SharedPtr<int> moved(std::move(second), target);
+    ASSERT_TRUE(!second && moved.UseCount() == 1);
+    moved.Reset();
+    ASSERT_TRUE(weak.Expired());
+}
+
+TEST(SharedAliasing, ViewsOfABuffer) {
+    auto buffer = MakeShared<char[]>(64, 'x');
+    std::vector<SharedPtr<char[]>> views;
+    for (int i = 0; i < 4; ++i) {
+        views.emplace_back(buffer, buffer.Get() + 16 * i);
+        views.back()[0] = static_cast<char>('a' + i);
+    }
+    buffer.Reset();
+    ASSERT_TRUE(views[0].UseCount() == 4 && views[3][0] == 'd' && views[3][1] == 'x');
+}
+
+// AllocateShared
+// Counts the blocks it hands out in a counter shared by its copies.
+template <typename T>
+struct CountingAllocator {
+    using value_type = T;
+
+    explicit CountingAllocator(int* live) : live(live) {
+    }
+
+    template <typename U>
+    CountingAllocator(const CountingAllocator<U>& other) : live(other.live) {  // NOLINT
+    }
+
+    T* allocate(std::size_t n) {  // NOLINT
+        ++*live;
+        return std::allocator<T>().allocate(n);
+    }
+
+    void deallocate(T* p, std::size_t n) {  // NOLINT
+        --*live;
+        std::allocator<T>().deallocate(p, n);
+    }
+
+    int* live;
+};
+
+TEST(AllocateShared, UsesAllocator) {
+    int live = 0;
+    WeakPtr<std::string> w;
+    {
+        SharedPtr<std::string> s =
+            AllocateShared<std::string>(CountingAllocator<char>(&live), 100, 'x');
+        SharedPtr<std::string> copy = s;
+        w = copy;
+        ASSERT_TRUE(live == 1 && *s == std::string(100, 'x') && s.UseCount() == 2);
+    }
+    ASSERT_TRUE(w.Expired() && live == 1);
+    w.Reset();
+    ASSERT_TRUE(live == 0);
+}
+
+// Lock policies
+TEST(SingleThreadPolicy, Counts) {
+    WeakPtr<std::string, SingleThreadPolicy> w;
+    {
+        auto s1 = MakeShared<std::string, SingleThreadPolicy>("value");
+        SharedPtr<std::string, SingleThreadPolicy> s2 = s1;
+        w = s2;
+        ASSERT_TRUE(s1.UseCount() == 2 && *w.Lock() == "value");
+        s1.Reset();
+        ASSERT_TRUE(s2.UseCount() == 1 && !w.Expired());
+    }
+    ASSERT_TRUE(w.Expired() && !w.Lock());
+}
+
+TEST(AtomicPolicy, CopiesAcrossThreads) {
+    auto shared = MakeShared<std::vector<int>>(1000, 7);
+    WeakPtr<std::vector<int>> weak(shared);
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; ++t) {
+        threads.emplace_back([shared, weak] {
+            for (int i = 0; i < 10000; ++i) {
+                SharedPtr<std::vector<int>> copy = shared;
+                SharedPtr<std::vector<int>> locked = weak.Lock();
+                ASSERT_TRUE(locked && (*copy)[i % 1000] == 7);
+            }
+        });
+    }
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+    ASSERT_TRUE(shared.UseCount() == 1);
+    shared.Reset();
+    ASSERT_TRUE(weak.Expired());
+}
+
+TEST(AtomicPolicy, LockRacesLastRelease) {
+    // Every object is destroyed exactly once, and a Lock that succeeds still
+    // sees it alive, however the lockers and the last release interleave.
+    for (int round = 0; round < 200; ++round) {
+        std::atomic<int> destroyed{0};
+        auto shared = SharedPtr<std::atomic<int>>(new std::atomic<int>(7),
+                                                  [&destroyed](std::atomic<int>* p) {
+                                                      p->store(0);
+                                                      ++destroyed;
+                                                      delete p;
+                                                  });
+        WeakPtr<std::atomic<int>> weak(shared);
+        std::atomic<bool> go{false};
+        std::vector<std::thread> threads;
+        for (int t = 0; t < 3; ++t) {
+            threads.emplace_back([&] {
+                while (!go.load()) {
+                }
+                for (int i = 0; i < 100; ++i) {
+                    SharedPtr<std::atomic<int>> locked = weak.Lock();
+                    ASSERT_TRUE(!locked || locked->load() == 7);
+                }
+            });
+        }
+        go = true;
+        shared.Reset();
+        for (std::thread& thread : threads) {
+            thread.join();
+        }
+        ASSERT_TRUE(destroyed == 1 && weak.Expired() && !weak.Lock());
+    }
+}
+
+// AtomicSharedPtr
+TEST(AtomicSharedPtr, LoadStoreExchange) {
+    AtomicSharedPtr<int> atomic;
+    ASSERT_TRUE(atomic.IsLockFree() && !atomic.Load());
+
+    auto first = MakeShared<int>(1);
+    atomic.Store(first);
+    ASSERT_TRUE(atomic.Load().Get() == first.Get());
+    ASSERT_TRUE(first.UseCount() == 2);
+
+    SharedPtr<int> old = atomic.Exchange(MakeShared<int>(2));
+    ASSERT_TRUE(old.Get() == first.Get() && *atomic.Load() == 2);
+    old.Reset();
+    ASSERT_TRUE(first.UseCount() == 1);
+}
+
+TEST(AtomicSharedPtr, CompareExchange) {
+    auto first = MakeShared<int>(1);
+    AtomicSharedPtr<int> atomic(first);
+
+    SharedPtr<int> expected;
+    ASSERT_FALSE(atomic.CompareExchange(expected, MakeShared<int>(3)));
+    ASSERT_TRUE(expected.Get() == first.Get() && *atomic.Load() == 1);
+
+    ASSERT_TRUE(atomic.CompareExchange(expected, MakeShared<int>(2)));
+    ASSERT_TRUE(*atomic.Load() == 2);
+    expected.Reset();
+    ASSERT_TRUE(first.UseCount() == 1);
+
+    // An equal value in another object does not count.
+    expected = MakeShared<int>(2);
+    ASSERT_FALSE(atomic.CompareExchange(expected, SharedPtr<int>()));
+    ASSERT_TRUE(atomic.CompareExchange(expected, SharedPtr<int>()));
+    ASSERT_FALSE(atomic.Load());
+}
+
+TEST(AtomicSharedPtr, ReadersAndWriters) {
+    // Every snapshot holds two equal numbers; a torn or freed one would not.
+    using Snapshot = std::pair<int, int>;
+    AtomicSharedPtr<Snapshot> atomic(MakeShared<Snapshot>(0, 0));
+    std::atomic<bool> done{false};
+
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; ++t) {
+        threads.emplace_back([&] {
+            while (!done.load()) {
+                SharedPtr<Snapshot> snapshot = atomic.Load();
+                ASSERT_TRUE(snapshot && snapshot->first == snapshot->second);
+            }
+        });
+    }
+    for (int t = 0; t < 2; ++t) {
+        threads.emplace_back([&, t] {
+            for (int i = 1; i <= 20000; ++i) {
+                if (t == 0) {
+                    atomic.Store(MakeShared<Snapshot>(i, i));
+                } else {
+                    SharedPtr<Snapshot> expected = atomic.Load();
+                    atomic.CompareExchange(expected, MakeShared<Snapshot>(-i, -i));
+                }
+            }
+        });
+    }
+    threads[4].join();
+    threads[5].join();
+    done = true;
+    for (int t = 0; t < 4; ++t) {
+        threads[t].join();
+    }
+    ASSERT_TRUE(atomic.Load().UseCount() == 2);
+}
+
+// SharedPtrReleaseBatch
+TEST(ReleaseBatch, DefersUntilFlush) {
+    auto shared = MakeShared<int>(5);
+    WeakPtr<int> weak(shared);
+    std::vector<SharedPtr<int>> copies(100, shared);
+    shared.Reset();
+
+    SharedPtrReleaseBatch<> batch;
+    batch.AddRange(copies.begin(), copies.end());
+    ASSERT_TRUE(!copies[0] && copies[99].UseCount() == 0);
+    ASSERT_TRUE(!weak.Expired() && weak.Lock().UseCount() == 101);
+    batch.Flush();
+    ASSERT_TRUE(weak.Expired());
+}
+
+TEST(ReleaseBatch, ManyControlBlocks) {
+    std::vector<SharedPtr<int, SingleThreadPolicy>> originals;
+    std::vector<WeakPtr<int, SingleThreadPolicy>> weaks;
+    for (int i = 0; i < 1000; ++i) {
+        originals.push_back(MakeShared<int, SingleThreadPolicy>(i));
+        weaks.emplace_back(originals.back());
+    }
+    {
+        SharedPtrReleaseBatch<SingleThreadPolicy> batch;
+        for (int round = 0; round < 3; ++round) {
+            for (const auto& original : originals) {
+                SharedPtr<int, SingleThreadPolicy> copy = original;
+                batch.Add(std::move(copy));
+            }
+        }
+        originals.clear();
+        // Blocks pushed out of a slot were released on the way, so only the
+        // objects still counted in a slot are alive.
+        const auto alive = std::count_if(weaks.begin(), weaks.end(),
+                                         [](auto& weak) { return !weak.Expired(); });
+        ASSERT_TRUE(alive > 0 && alive <= 64);
+    }
+    ASSERT_TRUE(std::all_of(weaks.begin(), weaks.end(), [](auto& weak) { return weak.Expired(); }));
+}
+
+// IntrusivePtr
+struct Tracked : RefCounted<Tracked> {
+    explicit Tracked(int& destroyed) : destroyed(destroyed) {
+    }
+    ~Tracked() {
+        ++destroyed;
+    }
+    int& destroyed;
+};
+
+TEST(IntrusivePtr, Counts) {
+    int destroyed = 0;
+    IntrusivePtr<Tracked> p1 = MakeIntrusive<Tracked>(destroyed);
+    {
+        IntrusivePtr<Tracked> p2 = p1;
+        // A raw pointer finds the same count.
+        IntrusivePtr<Tracked> p3(p2.Get());
+        ASSERT_TRUE(p1.UseCount() == 3 && p3.Get() == p1.Get());
+    }
+    ASSERT_TRUE(p1.UseCount() == 1 && destroyed == 0);
+    p1.Reset();
+    ASSERT_TRUE(!p1 && destroyed == 1);
+}
+
+TEST(IntrusivePtr, CopiedObjectStartsAtZero) {
+    int destroyed = 0;
+    IntrusivePtr<Tracked> p1 = MakeIntrusive<Tracked>(destroyed);
+    IntrusivePtr<Tracked> p2(new Tracked(*p1));
+    ASSERT_TRUE(p1.UseCount() == 1 && p2.UseCount() == 1);
+}
+
+TEST(IntrusivePtr, ToShared) {
+    int destroyed = 0;
+    IntrusivePtr<Tracked> intrusive = MakeIntrusive<Tracked>(destroyed);
+    SharedPtr<Tracked> shared = intrusive.ToShared();
+    SharedPtr<Tracked> copy = shared;
+    ASSERT_TRUE(intrusive.UseCount() == 2 && shared.UseCount() == 2);
+
+    intrusive.Reset();
+    ASSERT_TRUE(destroyed == 0);
+    IntrusivePtr<Tracked> back(copy.Get());
+    shared.Reset();
+    copy.Reset();
+    ASSERT_TRUE(destroyed == 0 && back.UseCount() == 1);
+    back.Reset();
+    ASSERT_TRUE(destroyed == 1);
+}
+
+// WeakValueCache
+TEST(WeakValueCache, ForgetsUnheldValues) {
+    WeakValueCache<int, std::string> cache;
+    SharedPtr<std::string> held = MakeShared<std::string>("held");
+    cache.Insert(1, held);
+    cache.Insert(2, MakeShared<std::string>("dropped"));
+
+    ASSERT_TRUE(cache.Find(1).Get() == held.Get());
+    ASSERT_TRUE(!cache.Find(2) && !cache.Find(3));
+    WeakValueCacheStats stats = cache.Stats();
+    ASSERT_TRUE(stats.hits == 1 && stats.misses == 2 && stats.swept == 1);
+    ASSERT_TRUE(cache.Size() == 1);
+
+    cache.Erase(1);
+    ASSERT_TRUE(!cache.Find(1) && *held == "held");
+}
+
+TEST(WeakValueCache, GetOrCreate) {
+    WeakValueCache<std::string, int> cache;
+    int made = 0;
+    auto make = [&made] { return MakeShared<int>(++made); };
+    SharedPtr<int> first = cache.GetOrCreate("a", make);
+    SharedPtr<int> second = cache.GetOrCreate("a", make);
+    ASSERT_TRUE(first.Get() == second.Get() && made == 1);
+
+    first.Reset();
+    second.Reset();
+    ASSERT_TRUE(*cache.GetOrCreate("a", make) == 2);
+}
+
+TEST(WeakValueCache, InsertionsSweepExpiredEntries) {
+    WeakValueCache<int, int> cache;
+    for (int i = 0; i < 10000; ++i) {
+        cache.Insert(i, MakeShared<int>(i));
+    }
+    // Each insertion sweeps a couple of buckets, so most of the dead
+    // entries are gone without any lookup for them.
+    ASSERT_TRUE(cache.Size() < 10000 / 2);
+    ASSERT_TRUE(cache.Stats().swept + cache.Size() == 10000);
+}
+
+TEST(WeakValueCache, ConcurrentGetOrCreate) {
+    WeakValueCache<int, std::pair<int, int>> cache;
+    std::vector<SharedPtr<std::pair<int, int>>> pinned(64);
+    for (int key = 0; key < 64; key += 2) {
+        pinned[key] = cache.GetOrCreate(key, [key] {
+            return MakeShared<std::pair<int, int>>(key, key);
+        });
+    }
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; ++t) {
+        threads.emplace_back([&cache] {
+            for (int i = 0; i < 20000; ++i) {
+                const int key = i % 64;
+                SharedPtr<std::pair<int, int>> value = cache.GetOrCreate(key, [key] {
+                    return MakeShared<std::pair<int, int>>(key, key);
+                });
+                ASSERT_TRUE(value->first == key && value->second == key);
+            }
+        });
+    }
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+    for (int key = 0; key < 64; key += 2) {
+        ASSERT_TRUE(cache.Find(key).Get() == pinned[key].Get());
+    }
+    WeakValueCacheStats stats = cache.Stats();
+    ASSERT_TRUE(stats.hits + stats.misses == 4 * 20000 + 64 / 2 + 64 / 2);
+}
+
+// task::Optional
+static_assert(sizeof(task::Optional<SharedPtr<int>>) == sizeof(SharedPtr<int>));
+static_assert(sizeof(task::Optional<SharedPtr<int[]>>) == sizeof(SharedPtr<int[]>));
+
+TEST(OptionalNiche, SharedPtr) {
+    task::Optional<SharedPtr<int>> opt;
+    ASSERT_FALSE(opt.HasValue());
+    opt = SharedPtr<int>();
+    ASSERT_TRUE(opt.HasValue() && !*opt);
+
+    auto shared = MakeShared<int>(3);
+    opt = shared;
+    task::Optional<SharedPtr<int>> copy = opt;
+    ASSERT_TRUE(**copy == 3 && shared.UseCount() == 3);
+    opt.Reset();
+    copy = task::kNullOpt;
+    ASSERT_TRUE(!opt && !copy && shared.UseCount() == 1);
+}
+
 int main(int argc, char** argv) {
     ::testing::InitGoogleTest(&argc, argv);
     return RUN_ALL_TESTS();